@@ -2,7 +2,7 @@
  * cracker.h
  * 多线程CRC32破解模块头文件
  *
- * 使用Pthreads实现并行暴力破解
+ * 使用常驻线程池 (thread_pool.h) 实现并行暴力破解
  * 支持全空间(0-40亿)秒级扫描
  */
 
@@ -29,12 +29,15 @@ typedef struct {
 } CrackResult;
 
 /**
- * 破解CRC32 Hash，返回所有碰撞候选
+ * 尾部反演破解：按 UID 长度枚举前缀，直接反解最后 4 个字符
  * @param hex_hash 16进制格式的CRC32哈希值
- * @param thread_count 并行线程数量
- * @param result 输出参数，存储所有碰撞候选
+ * @param result 输出参数，存储所有碰撞候选 (升序)
  * @return 找到的候选数量
+ *
+ * 说明:
+ *   - 与 crack_hash 覆盖相同范围 (0 至 MAX_UID-1)，返回该范围内全部碰撞
+ *   - 10 位 UID 仅需枚举约 22 万个前缀，单线程毫秒级完成
  */
-int crack_hash_all(const char *hex_hash, int thread_count, CrackResult *result);
+int crack_hash_invert(const char *hex_hash, CrackResult *result);
 
 #endif // CRACKER_H
@@ -4,6 +4,7 @@
  *
  * 多项式: 0xEDB88320
  * 使用查表法(Sarwate算法)实现高速CRC32计算
+ * 长输入自动切换到 Slicing-by-8 / Slicing-by-16 (扩展表见 crc32_core.c)
  */
 
 #ifndef CRC32_CORE_H
@@ -60,6 +61,125 @@ static const uint32_t crc32_table[256] = {
     0x54de5729, 0x23d967bf, 0xb3667a2e, 0xc4614ab8, 0x5d681b02, 0x2a6f2b94,
     0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d};
 
+// CRC32 反向索引表: crc32_rev_table[crc32_table[i] >> 24] = i
+// crc32_table 中 256 个表项的最高字节互不相同，
+// 因此可由推进后状态的最高字节唯一反推出本步的查表下标
+static const uint8_t crc32_rev_table[256] = {
+    0x00, 0x41, 0xc3, 0x82, 0x86, 0xc7, 0x45, 0x04, 0x4d, 0x0c, 0x8e, 0xcf,
+    0xcb, 0x8a, 0x08, 0x49, 0x9a, 0xdb, 0x59, 0x18, 0x1c, 0x5d, 0xdf, 0x9e,
+    0xd7, 0x96, 0x14, 0x55, 0x51, 0x10, 0x92, 0xd3, 0x75, 0x34, 0xb6, 0xf7,
+    0xf3, 0xb2, 0x30, 0x71, 0x38, 0x79, 0xfb, 0xba, 0xbe, 0xff, 0x7d, 0x3c,
+    0xef, 0xae, 0x2c, 0x6d, 0x69, 0x28, 0xaa, 0xeb, 0xa2, 0xe3, 0x61, 0x20,
+    0x24, 0x65, 0xe7, 0xa6, 0xea, 0xab, 0x29, 0x68, 0x6c, 0x2d, 0xaf, 0xee,
+    0xa7, 0xe6, 0x64, 0x25, 0x21, 0x60, 0xe2, 0xa3, 0x70, 0x31, 0xb3, 0xf2,
+    0xf6, 0xb7, 0x35, 0x74, 0x3d, 0x7c, 0xfe, 0xbf, 0xbb, 0xfa, 0x78, 0x39,
+    0x9f, 0xde, 0x5c, 0x1d, 0x19, 0x58, 0xda, 0x9b, 0xd2, 0x93, 0x11, 0x50,
+    0x54, 0x15, 0x97, 0xd6, 0x05, 0x44, 0xc6, 0x87, 0x83, 0xc2, 0x40, 0x01,
+    0x48, 0x09, 0x8b, 0xca, 0xce, 0x8f, 0x0d, 0x4c, 0x95, 0xd4, 0x56, 0x17,
+    0x13, 0x52, 0xd0, 0x91, 0xd8, 0x99, 0x1b, 0x5a, 0x5e, 0x1f, 0x9d, 0xdc,
+    0x0f, 0x4e, 0xcc, 0x8d, 0x89, 0xc8, 0x4a, 0x0b, 0x42, 0x03, 0x81, 0xc0,
+    0xc4, 0x85, 0x07, 0x46, 0xe0, 0xa1, 0x23, 0x62, 0x66, 0x27, 0xa5, 0xe4,
+    0xad, 0xec, 0x6e, 0x2f, 0x2b, 0x6a, 0xe8, 0xa9, 0x7a, 0x3b, 0xb9, 0xf8,
+    0xfc, 0xbd, 0x3f, 0x7e, 0x37, 0x76, 0xf4, 0xb5, 0xb1, 0xf0, 0x72, 0x33,
+    0x7f, 0x3e, 0xbc, 0xfd, 0xf9, 0xb8, 0x3a, 0x7b, 0x32, 0x73, 0xf1, 0xb0,
+    0xb4, 0xf5, 0x77, 0x36, 0xe5, 0xa4, 0x26, 0x67, 0x63, 0x22, 0xa0, 0xe1,
+    0xa8, 0xe9, 0x6b, 0x2a, 0x2e, 0x6f, 0xed, 0xac, 0x0a, 0x4b, 0xc9, 0x88,
+    0x8c, 0xcd, 0x4f, 0x0e, 0x47, 0x06, 0x84, 0xc5, 0xc1, 0x80, 0x02, 0x43,
+    0x90, 0xd1, 0x53, 0x12, 0x16, 0x57, 0xd5, 0x94, 0xdd, 0x9c, 0x1e, 0x5f,
+    0x5b, 0x1a, 0x98, 0xd9};
+
+/**
+ * 单字节 CRC32 状态推进 (Sarwate 单步)
+ * @param crc 当前内部状态 (未取反)
+ * @param byte 输入字节
+ * @return 推进后的内部状态
+ */
+static inline uint32_t crc32_step(uint32_t crc, uint8_t byte) {
+  return (crc >> 8) ^ crc32_table[(crc ^ byte) & 0xFF];
+}
+
+// ============== 多核函数调度 ==============
+
+// 可选的 CRC32 计算核
+typedef enum {
+  CRC32_KERNEL_AUTO = 0, // 按输入长度自动选择 (默认)
+  CRC32_KERNEL_SARWATE,  // 逐字节查表 (1 张表)
+  CRC32_KERNEL_SLICE8,   // Slicing-by-8 (8 张表，每次 8 字节)
+  CRC32_KERNEL_SLICE16,  // Slicing-by-16 (16 张表，每次 16 字节)
+  CRC32_KERNEL_CLMUL,    // PCLMULQDQ 折叠 (x86-64，不可用时退回 Slicing-by-16)
+  CRC32_KERNEL_COUNT
+} Crc32Kernel;
+
+/**
+ * 初始化扩展查找表 (Slicing-by-8/16) 与数字贡献表 (crc32_digits.h)
+ * 说明: 首次调用 crc32_update 时会自动初始化；可在任意线程上并发调用，
+ * 只有一个线程生成表，其余线程等待其完成 (仍建议在启动线程前显式调用一次)
+ */
+void crc32_init(void);
+
+/**
+ * 统一的 CRC32 调度入口 (项目内所有整串 CRC 计算都经过这里)
+ * @param crc 当前内部状态 (新计算传 0xFFFFFFFF)
+ * @param buf 输入数据
+ * @param len 数据长度
+ * @return 推进后的内部状态 (未取反)
+ */
+uint32_t crc32_update(uint32_t crc, const void *buf, size_t len);
+
+/**
+ * 强制指定计算核 (用于基准测试或排查问题)
+ */
+void crc32_select_kernel(Crc32Kernel kernel);
+
+/**
+ * 获取计算核名称
+ */
+const char *crc32_kernel_name(Crc32Kernel kernel);
+
+/**
+ * 批量计算 N 个等长字符串的 CRC32
+ * @param data 第一个字符串首地址
+ * @param stride 相邻字符串起始地址的间距 (字节)
+ * @param len 每个字符串的长度
+ * @param count 字符串数量
+ * @param out 输出：out[i] = crc32_fast(data + i * stride, len)
+ *
+ * 说明: CPU 支持 PCLMULQDQ 时按 8 字节做 Barrett 归约，
+ * 多个字符串交错成并行通道计算；否则逐个走 crc32_update
+ * 目前仅供 crc32_benchmark 对比使用：MITM 建表改用数字贡献表
+ * (crc32_digits.h) 逐位异或，比按字节计算 CRC 更快，不经过此接口
+ */
+void crc32_batch_fixed(const void *data, size_t stride, size_t len,
+                       size_t count, uint32_t *out);
+
+/**
+ * 基准测试：对比各计算核在 1-19 字节数字串及大块数据上的耗时
+ */
+void crc32_benchmark(void);
+
+// ============== PCLMULQDQ 加速路径 (crc32_clmul.c) ==============
+
+/**
+ * 检测 CPU 是否支持 PCLMULQDQ + SSE4.1 (CPUID，结果缓存)
+ * @return 1=支持, 0=不支持或非 x86 平台
+ */
+int crc32_clmul_available(void);
+
+/**
+ * 大块数据折叠 (每次 64 字节 4 路并行折叠，尾部走查表)
+ * 调用前须确认 crc32_clmul_available() 返回 1
+ * (实验性：AUTO 仅在 len >= 64 时选用，项目内的 UID 串最长 19 字节，
+ * 目前只有 crc32_benchmark 的大块测试与自检会走到这里)
+ */
+uint32_t crc32_update_clmul(uint32_t crc, const void *buf, size_t len);
+
+/**
+ * 批量路径的 CLMUL 实现，调用前须确认 crc32_clmul_available() 返回 1
+ * (仅由 crc32_batch_fixed 调用，同样只用于基准测试)
+ */
+void crc32_batch_fixed_clmul(const uint8_t *data, size_t stride, size_t len,
+                             size_t count, uint32_t *out);
+
 /**
  * 快速CRC32计算函数
  * @param str 输入字符串指针
@@ -67,13 +187,34 @@ static const uint32_t crc32_table[256] = {
  * @return 计算出的CRC32值（已取反）
  */
 static inline uint32_t crc32_fast(const char *str, size_t len) {
-  uint32_t crc = 0xFFFFFFFF; // 初始异或值
-  for (size_t i = 0; i < len; i++) {
-    // 查表核心逻辑：(当前CRC低8位 XOR 新字节) 作为索引
-    uint8_t table_index = (crc ^ (uint8_t)str[i]) & 0xFF;
-    crc = (crc >> 8) ^ crc32_table[table_index];
-  }
-  return ~crc; // 最终异或值
+  return ~crc32_update(0xFFFFFFFF, str, len); // 初始值/最终异或值
+}
+
+// ============== 移位算子 (CRC 拼接) ==============
+
+/**
+ * CRC 移位算子：Shift_len(crc) = crc * x^(8 * len) mod P
+ * 即在数据后追加 len 个零字节对 CRC 线性部分的作用，满足
+ *   CRC(A || B) = Shift_|B|(CRC(A)) ^ CRC(B)
+ * 算子对 crc 线性，按输入字节拆成 4 张 256 项表：一次应用 = 4 次查表 + 3 次异或
+ */
+typedef struct {
+  uint64_t len;           // 移位字节数
+  uint32_t table[4][256]; // table[k][b]: 输入第 k 字节为 b 时的贡献
+} Crc32ShiftOp;
+
+/**
+ * 构建移位 len 字节的算子 (每项 32 次多项式乘法步，共 1024 项)
+ */
+void crc32_shift_op_init(Crc32ShiftOp *op, uint64_t len);
+
+/**
+ * 应用移位算子
+ */
+static inline uint32_t crc32_shift_apply(const Crc32ShiftOp *op,
+                                         uint32_t crc) {
+  return op->table[0][crc & 0xFF] ^ op->table[1][(crc >> 8) & 0xFF] ^
+         op->table[2][(crc >> 16) & 0xFF] ^ op->table[3][crc >> 24];
 }
 
 #endif // CRC32_CORE_H
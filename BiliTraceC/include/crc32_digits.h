@@ -0,0 +1,64 @@
+/**
+ * crc32_digits.h
+ * 数字贡献异或表 - 利用 CRC32 的仿射性质批量计算十进制串的 CRC
+ *
+ * CRC32 在 GF(2) 上是仿射的：对固定长度 n 的数字串 s，
+ *   CRC(s) = CRC("0" * n) ^ XOR_j contrib[j][s 的倒数第 j 位]
+ * 其中 contrib[j][d] 只与该位到串尾的距离 j 和数字 d 有关。
+ * 因此每个长度 n 的贡献表就是 contrib[0..n-1] 这 n x 10 项，
+ * 所有长度共享同一张 19 x 10 表，仅常数 base[n] 随长度变化。
+ */
+
+#ifndef CRC32_DIGITS_H
+#define CRC32_DIGITS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define DIGITS_MAX_LEN 19 // uint64_t 中可完整枚举的最大位数
+#define DIGITS_TAIL_SPAN 1000 // 尾部扫描一次覆盖的候选数 (末 3 位)
+
+typedef struct {
+  uint32_t base[DIGITS_MAX_LEN + 1];    // base[n] = CRC32("0" * n)
+  uint32_t contrib[DIGITS_MAX_LEN][10]; // contrib[j][d]: 倒数第 j 位为 d 的贡献
+} Crc32DigitTables;
+
+/**
+ * 构建贡献表 (由 crc32_init 调用，重复或并发调用均安全，只构建一次)
+ */
+void crc32_digits_init(void);
+
+/**
+ * 获取贡献表 (只读)
+ */
+const Crc32DigitTables *crc32_digits_tables(void);
+
+/**
+ * 计算数值十进制表示 (无前导零) 的 CRC32，与 crc32_fast 结果一致
+ * 各位查表互不依赖，无逐字节的串行依赖链
+ * 要求 value < 10^19
+ */
+uint32_t crc32_digits_eval(uint64_t value);
+
+/**
+ * 批量计算 CRC32：out[i] = crc32_digits_eval(values[i])
+ * CPU 支持 AVX2 时每次并行处理 8 个值 (向量除 10 + gather 查表)
+ */
+void crc32_digits_eval_batch(const uint64_t *values, size_t count,
+                             uint32_t *out);
+
+/**
+ * 尾部扫描：在共享前缀的 1000 个候选中找出 CRC 等于目标的那些
+ * @param prefix_crc 前缀后接 "000" 的完整 CRC32 (即 CRC(p * 1000))
+ * @param target 目标 CRC32
+ * @param hits 输出：命中的末 3 位数值 (0-999)，升序
+ * @param max_hits hits 容量
+ * @return 命中数量
+ *
+ * 说明: 候选 CRC = prefix_crc ^ tail[t]，只需异或 + 比较；
+ * AVX2 每条指令比较 8 个候选 (循环展开为 16)，SSE2 每条 4 个
+ */
+int crc32_digits_scan_tail(uint32_t prefix_crc, uint32_t target,
+                           uint16_t *hits, int max_hits);
+
+#endif // CRC32_DIGITS_H
@@ -1,6 +1,7 @@
 #ifndef MITM_CRACKER_H
 #define MITM_CRACKER_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 // ============== 配置常量 ==============
@@ -8,13 +9,56 @@
 #define LOW_PART_DIGITS 8        // 低位数字位数
 #define MAX_MITM_RESULTS 2000000 // 最大碰撞候选数 (扩容至200万，约16MB内存)
 
+#define MITM_BUCKET_BITS 24 // 分桶索引：CRC 高 24 位作为桶号
+#define MITM_BUCKET_COUNT (1u << MITM_BUCKET_BITS)
+#define MITM_REM_BITS (32 - MITM_BUCKET_BITS) // 桶内保存的剩余 CRC 位数
+
 // ============== 数据结构 ==============
 
-// CRC32 表项
+// 查询策略
+typedef enum {
+  MITM_PLAN_AUTO = 0, // 按表是否就绪与高位集合规模自动选择 (默认)
+  MITM_PLAN_TABLE,    // 查表：逐个高位在预计算表中探测 (需先 mitm_init)
+  MITM_PLAN_STREAM,   // 无表：所需 CRC(L) 建小哈希集合，流式扫描 10^8 个低位
+  MITM_PLAN_MERGE,    // 归并：所需 CRC(L) 基数排序后与表顺序归并 (需先 mitm_init)
+                      // AUTO 不会选择归并，仅供基准对比
+} MitmPlan;
+
+// 表探测前的成员过滤器 (随表构建并保存在缓存文件中)
+typedef enum {
+  MITM_FILTER_NONE = 0, // 不使用过滤器
+  MITM_FILTER_BLOOM,    // 2^29 位分块布隆过滤器 (64 MB，默认)
+  MITM_FILTER_BITMAP,   // 2^32 位精确位图 (512 MB，无误判)
+} MitmFilter;
+
+// 表加载配置 (须在 mitm_init 之前设置)
 typedef struct {
-  uint32_t crc; // CRC32 值
-  uint32_t low; // 对应的低位数值
-} CrcEntry;
+  int use_mmap; // 1=只读映射缓存文件，同机多进程共享页缓存 (默认)；0=整表读入
+  int prefetch; // 1=映射后立即预读整表 (MAP_POPULATE / WILLNEED)；0=按需缺页
+  int huge_pages; // 1=读入私有大页内存以减少 TLB 缺失 (优先于 use_mmap)，
+                  //   不可用时自动退回普通页
+  MitmFilter filter; // 成员过滤器类型，与缓存文件不一致时重建表
+} MitmConfig;
+
+// 表镜像的后备内存类型
+typedef enum {
+  MITM_BACKING_NONE = 0, // 表未加载
+  MITM_BACKING_HEAP,     // 普通堆内存
+  MITM_BACKING_MAPPED,   // 只读映射缓存文件
+  MITM_BACKING_HUGE,     // 显式大页 (MAP_HUGETLB / MEM_LARGE_PAGES)
+  MITM_BACKING_THP,      // 透明大页 (MADV_HUGEPAGE，实际覆盖见 huge_bytes)
+} MitmBacking;
+
+// 表内存统计
+typedef struct {
+  MitmBacking backing;
+  size_t table_bytes;    // 表镜像大小
+  size_t huge_bytes;     // 其中实际由大页映射的字节数
+  size_t huge_page_size; // 大页大小
+  size_t huge_pages;     // 大页数量 (huge_bytes / huge_page_size)
+  MitmFilter filter;     // 成员过滤器类型
+  size_t filter_bytes;   // 过滤器大小 (已计入 table_bytes)
+} MitmStats;
 
 // MITM 结果集
 typedef struct {
@@ -23,8 +67,42 @@ typedef struct {
   int capacity;   // 数组容量
 } MitmResult;
 
+// 流式候选回调：每个验证通过的候选调用一次 (按发现顺序，非升序)
+// 可能在任意工作线程上调用，但各次调用互斥、不会并发；回调不在内部锁内执行，
+// 耗时回调只占用当前投递的线程，其余线程把候选入队后继续搜索
+// 返回非 0 表示停止搜索 (尚未开始的区间直接跳过)
+typedef int (*MitmCandidateFn)(uint64_t uid, void *user);
+
+// 批量查询的单条结果
+typedef struct {
+  uint64_t uid;
+  uint32_t target_index; // 所属目标在输入数组中的下标
+} MitmMatch;
+
+// 批量查询结果集 (按目标下标、UID 升序)
+typedef struct {
+  MitmMatch *matches; // 动态分配，调用者负责 free
+  int count;
+  int capacity;
+} MitmBatchResult;
+
 // ============== 函数声明 ==============
 
+/**
+ * 设置表加载配置 (在 mitm_init 之前调用；默认映射、不预读)
+ */
+void mitm_configure(const MitmConfig *config);
+
+/**
+ * 获取当前表加载配置
+ */
+void mitm_get_config(MitmConfig *config);
+
+/**
+ * 获取成员过滤器类型名称
+ */
+const char *mitm_filter_name(MitmFilter filter);
+
 /**
  * 初始化 MITM 模块 (加载或构建表)
  *
@@ -32,11 +110,41 @@ typedef struct {
  * @return 0=成功, -1=失败
  *
  * 说明:
- *   - 如果缓存文件存在，直接加载 (<100ms)
- *   - 如果不存在，执行预计算并保存 (~0.8s with 24 threads)
+ *   - 如果缓存文件存在，以只读方式映射 (几乎零开销，多进程共享一份物理内存)
+ *   - 如果不存在，执行预计算并保存 (单线程池线程实测约 5.4 秒，各阶段经线程池并行)
+ *   - 缓存格式版本、字节序或过滤器类型不符时自动重建
  */
 int mitm_init(const char *cache_path);
 
+/**
+ * 在后台线程上异步初始化 MITM 模块 (加载或构建表)，立即返回
+ *
+ * @param cache_path 缓存文件路径 (NULL 使用默认路径)
+ * @return 0=已启动 (或已就绪), -1=无法创建线程
+ *
+ * 说明:
+ *   - 预热期间 mitm_is_ready 返回 0；查询接口不等待，直接使用无表模式
+ *   - mitm_init / mitm_wait_ready / mitm_cleanup 会等待预热完成，
+ *     须与 mitm_init_async 在同一线程上调用；查询可在任意线程上调用
+ *   - 缓存无效需构建表时，各构建阶段经 thread_pool_run 占用线程池；
+ *     线程池一次只执行一批任务，此时其他线程提交的任务 (无表查询、
+ *     crack_hash 等) 会排队到当前阶段结束。映射有效缓存不占用线程池
+ */
+int mitm_init_async(const char *cache_path);
+
+/**
+ * 缓存文件是否存在且与当前配置一致 (只读文件头，不加载表)
+ * @param cache_path 缓存文件路径 (NULL 使用默认路径)
+ * @return 1=可直接映射或读入, 0=不存在或需要重建
+ */
+int mitm_cache_valid(const char *cache_path);
+
+/**
+ * 等待后台预热完成
+ * @return 0=表已就绪, -1=初始化失败或从未初始化
+ */
+int mitm_wait_ready(void);
+
 /**
  * 使用 MITM 攻击破解 CRC32 哈希
  *
@@ -45,12 +153,65 @@ int mitm_init(const char *cache_path);
  * @return 找到的候选数量，或 -1 表示错误
  *
  * 说明:
- *   - 支持 1-16 位数字 UID
- *   - 0.2 秒内完成全空间搜索
+ *   - 支持 1-16 位数字 UID (含 0-2.2B 旧版 UID，无需再暴力扫描)
+ *   - 只遍历 UID 白名单 (旧版 0-2.2B 与 16 位前缀) 对应的高位区间，
+ *     区间由常驻线程池并行遍历
+ *   - 未调用 mitm_init 时自动使用无表模式，无需加载预计算表
+ *   - 结果按 UID 升序排列
+ *   - 结果数组写满 (capacity) 时提前停止搜索并提示
  *   - 可能返回多个碰撞候选
  */
 int mitm_crack(const char *target_hash, MitmResult *result);
 
+/**
+ * 流式破解：每找到一个候选立即交给回调，回调可要求提前停止
+ *
+ * @param target_hash 目标 CRC32 哈希值 (十六进制字符串)
+ * @param fn 候选回调 (见 MitmCandidateFn)
+ * @param user 透传给回调的上下文
+ * @return 交给回调的候选数量，或 -1 表示错误
+ *
+ * 说明:
+ *   - 策略选择与过滤规则与 mitm_crack 相同，不限制候选数量
+ *   - 回调执行期间其余线程继续搜索，适合边搜索边做耗时的在线验证
+ *   - 候选在每批探测 (无表/归并模式为每个检查点) 后即交出，不等攒满一批
+ */
+int mitm_crack_stream(const char *target_hash, MitmCandidateFn fn,
+                      void *user);
+
+/**
+ * 批量破解多个 CRC32 哈希 (如同一历史分段中的多条弹幕)
+ *
+ * @param targets 目标 CRC32 数组
+ * @param n 目标数量
+ * @param result 输出参数 (matches 为 NULL 时自动分配)，结果带目标下标
+ * @return 找到的候选总数，或 -1 表示错误
+ *
+ * 说明:
+ *   - 表已加载时每个高位的 Shift(CRC(h)) 只计算一次，多一个目标只多一次探测
+ *   - 表未加载时退化为逐个目标的无表扫描
+ *   - 候选过滤规则与 mitm_crack 相同
+ */
+int mitm_crack_batch(const uint32_t *targets, size_t n,
+                     MitmBatchResult *result);
+
+/**
+ * 强制指定查询策略 (用于基准测试或排查问题)
+ */
+void mitm_select_plan(MitmPlan plan);
+
+/**
+ * 获取查询策略名称
+ */
+const char *mitm_plan_name(MitmPlan plan);
+
+/**
+ * 查询策略基准测试：在稀疏 (白名单) 与稠密高位集合上对比查表探测与归并连接
+ * 并在稠密集合上对比不同探测批大小的每秒探测次数
+ * 表未加载时先调用 mitm_init(NULL)
+ */
+void mitm_benchmark(void);
+
 /**
  * 释放 MITM 模块资源
  */
@@ -67,6 +228,11 @@ int mitm_is_ready(void);
  */
 size_t mitm_get_table_size_mb(void);
 
+/**
+ * 获取表内存统计 (后备类型与大页覆盖情况，用于确认大页是否生效)
+ */
+void mitm_get_stats(MitmStats *stats);
+
 /**
  * 测试 MITM 数学逻辑
  * 用于验证 CRC32 combine 的"异或三明治"问题是否修复
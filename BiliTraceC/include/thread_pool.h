@@ -0,0 +1,57 @@
+/**
+ * thread_pool.h
+ * 常驻工作线程池模块头文件
+ *
+ * 进程启动时创建一次 (与 network_init 同步)，退出时销毁
+ * 所有破解任务复用同一组线程，避免每个 Hash 都重复创建/销毁线程
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stddef.h>
+
+#define POOL_MAX_THREADS 64
+
+/**
+ * 任务函数：arg 指向调用者提供的任务上下文 (如 ThreadContext)
+ */
+typedef void (*PoolTaskFunc)(void *arg);
+
+/**
+ * 创建线程池
+ * @param thread_count 工作线程数量 (<=0 时使用 CPU 逻辑核心数)
+ * @return 0=成功, -1=失败
+ *
+ * 说明: 重复调用无副作用，已创建时直接返回 0；
+ * 不是线程安全的，须在提交任务的线程 (含 MITM 预热线程) 启动前调用
+ */
+int thread_pool_init(int thread_count);
+
+/**
+ * 销毁线程池，等待所有工作线程退出
+ */
+void thread_pool_cleanup(void);
+
+/**
+ * 获取线程池工作线程数量 (未初始化返回 0)
+ */
+int thread_pool_size(void);
+
+/**
+ * 并行执行一批任务，阻塞直到全部完成
+ * @param func 任务函数
+ * @param args 任务上下文数组首地址
+ * @param arg_size 单个上下文的字节数
+ * @param task_count 任务数量，第 i 个任务收到 args + i * arg_size
+ * @return 0=成功, -1=失败
+ *
+ * 说明:
+ *   - 须先在主线程调用 thread_pool_init，未初始化时返回 -1
+ *   - 同一时刻只执行一批任务，并发调用者会排队等待
+ *   - 在工作线程内嵌套调用时退化为当前线程串行执行 (防止死锁)
+ */
+int thread_pool_run(PoolTaskFunc func, void *args, size_t arg_size,
+                    int task_count);
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,90 @@
+/**
+ * uid_odometer.h
+ * 十进制里程表枚举器 - 增量 CRC32 计算
+ *
+ * 以字符数组形式维护当前 UID 的十进制表示，并缓存每个前缀长度的
+ * Sarwate CRC 内部状态。递增时只有发生变化的尾部数字需要重新哈希，
+ * 相邻 UID 平均每步只需约 1.1 次查表，无需逐位除法。
+ */
+
+#ifndef UID_ODOMETER_H
+#define UID_ODOMETER_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "crc32_core.h"
+#include "utils.h"
+
+#define ODOMETER_MAX_DIGITS 20 // uint64_t 最多 20 位十进制
+
+typedef struct {
+  char digits[ODOMETER_MAX_DIGITS]; // 十进制字符 (不含 '\0')
+  int len;                          // 当前位数
+  // state[i] = 处理前 i 个字符后的 CRC 内部状态，state[0] = 0xFFFFFFFF
+  uint32_t state[ODOMETER_MAX_DIGITS + 1];
+} UidOdometer;
+
+// 从第 pos 个字符开始重新推进前缀状态
+static inline void uid_odometer_rehash_from(UidOdometer *od, int pos) {
+  for (int i = pos; i < od->len; i++) {
+    od->state[i + 1] = crc32_step(od->state[i], (uint8_t)od->digits[i]);
+  }
+}
+
+/**
+ * 初始化里程表
+ * @param od 里程表
+ * @param value 起始数值
+ */
+static inline void uid_odometer_init(UidOdometer *od, uint64_t value) {
+  od->len = (int)fast_uid_to_str(value, od->digits);
+  od->state[0] = 0xFFFFFFFF;
+  uid_odometer_rehash_from(od, 0);
+}
+
+/**
+ * 在第 pos 位 (从左数，0 起) 加 1 并处理进位，pos 之后的位全部清零
+ * pos = len-1 等价于数值 +1；pos = len-2 等价于跳到下一个整十
+ * 进位溢出时位数增长 (如 "999" -> "1000")
+ */
+static inline void uid_odometer_bump(UidOdometer *od, int pos) {
+  for (int i = pos + 1; i < od->len; i++) {
+    od->digits[i] = '0';
+  }
+
+  int i = pos;
+  while (i >= 0 && od->digits[i] == '9') {
+    od->digits[i] = '0';
+    i--;
+  }
+
+  if (i < 0) {
+    // 位数增长：最高位补 1，其余已全部为 0
+    memmove(od->digits + 1, od->digits, (size_t)od->len);
+    od->digits[0] = '1';
+    od->len++;
+    i = 0;
+  } else {
+    od->digits[i]++;
+  }
+
+  // 仅重新哈希变化位置之后的前缀
+  uid_odometer_rehash_from(od, i);
+}
+
+/**
+ * 数值 +1
+ */
+static inline void uid_odometer_next(UidOdometer *od) {
+  uid_odometer_bump(od, od->len - 1);
+}
+
+/**
+ * 当前数值的 CRC32 (已取反，与 crc32_fast 结果一致)
+ */
+static inline uint32_t uid_odometer_crc(const UidOdometer *od) {
+  return ~od->state[od->len];
+}
+
+#endif // UID_ODOMETER_H
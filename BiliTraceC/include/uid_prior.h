@@ -0,0 +1,49 @@
+/**
+ * uid_prior.h
+ * UID 先验密度 - 按活跃用户的前缀分布给碰撞候选排序
+ *
+ * 先验文件由 scripts/analyze_uid_prefixes.py 生成 (默认 uid_prior.bin)，
+ * 记录采样到的 UID 在各区间内的数量：
+ *   - 旧版 UID (<= 2.2B)：按 uid / 10^8 分为 23 个区间
+ *   - 16 位 UID：按前 5 位分区间
+ * CRC 碰撞候选在搜索空间内近似均匀分布，候选为真实账号的概率
+ * 正比于所在区间的采样密度 (区间计数 / 区间内 UID 个数)。
+ */
+
+#ifndef UID_PRIOR_H
+#define UID_PRIOR_H
+
+#include <stdint.h>
+
+#define UID_PRIOR_DEFAULT_PATH "uid_prior.bin"
+
+/**
+ * 加载先验文件 (重复调用会替换已加载的数据)
+ * @param path 文件路径 (NULL 使用默认路径)
+ * @return 0=成功, -1=文件不存在或格式不符
+ */
+int uid_prior_load(const char *path);
+
+/**
+ * 检查先验是否已加载
+ * @return 1=已加载, 0=未加载
+ */
+int uid_prior_loaded(void);
+
+/**
+ * 候选 UID 的先验密度 (相对值，仅用于比较；未加载或不在任何区间时为 0)
+ */
+double uid_prior_score(uint64_t uid);
+
+/**
+ * 按先验密度降序重排候选 (同分保持原顺序)；未加载时不改变顺序
+ * @return 0=成功, -1=内存不足 (顺序不变)
+ */
+int uid_prior_rank(uint64_t *uids, int count);
+
+/**
+ * 释放已加载的先验
+ */
+void uid_prior_free(void);
+
+#endif // UID_PRIOR_H
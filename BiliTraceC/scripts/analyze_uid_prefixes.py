@@ -5,9 +5,10 @@ analyze_uid_prefixes.py - 16位 UID 前缀分析器 v2
 流程：
 1. 采集：爬取热门视频评论区，获取2000+活跃用户
 2. 聚类：筛选16位UID，统计前缀分布 (5位粒度)
-3. 输出：生成 C 代码白名单规则
+3. 输出：生成 C 代码白名单规则，以及候选排序用的先验文件 uid_prior.bin
 """
 
+import struct
 import time
 from collections import Counter
 from typing import List, Set, Tuple
@@ -17,6 +18,11 @@ import requests
 # ============ 配置 ============
 TARGET_COUNT = 2000  # 目标采集数量
 REQUEST_DELAY = 0.4  # 请求间隔
+PRIOR_PATH = "uid_prior.bin"  # 先验文件 (与 src/uid_prior.c 的格式一致)
+PRIOR_MAGIC = 0x50444955  # "UIDP"
+PRIOR_VERSION = 1
+LEGACY_UID_MAX = 2200000000  # 旧版 UID 上限
+LEGACY_BINS = 23  # 旧版 UID 按 uid // 10^8 分区间
 
 HEADERS = {
     "User-Agent": "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 "
@@ -202,6 +208,28 @@ def generate_c_code(prefix_counter: Counter) -> str:
     return code
 
 
+def write_prior_file(uids: Set[int], path: str = PRIOR_PATH) -> None:
+    """生成先验文件：旧版 UID 区间计数 + 16位 UID 前5位计数 (小端 uint32)"""
+    print("\n" + "=" * 60)
+    print("Step 4: 生成候选排序先验 (uid_prior.bin)")
+    print("=" * 60)
+
+    legacy = [0] * LEGACY_BINS
+    for u in uids:
+        if 0 < u <= LEGACY_UID_MAX:
+            legacy[u // 100000000] += 1
+    prefixes = sorted(Counter(int(get_prefix(u, 5)) for u in uids if is_16digit(u)).items())
+
+    with open(path, "wb") as f:
+        f.write(struct.pack("<5I", PRIOR_MAGIC, PRIOR_VERSION, len(uids),
+                            LEGACY_BINS, len(prefixes)))
+        f.write(struct.pack(f"<{LEGACY_BINS}I", *legacy))
+        for prefix, count in prefixes:
+            f.write(struct.pack("<2I", prefix, count))
+
+    print(f"\n[已保存] {path} ({sum(legacy)} 个旧版 UID, {len(prefixes)} 个 16位前缀)")
+
+
 def main():
     print("\n" + "=" * 60)
     print("16位 UID 前缀分析器 v2")
@@ -217,6 +245,8 @@ def main():
     
     if prefix4:
         generate_c_code(prefix4)
+
+    write_prior_file(uids)
     
     print("\n[完成]")
 
@@ -4,8 +4,10 @@
  *
  * 设计原则：
  * 1. 线程本地化结果：每个线程仅写入自己的上下文，无共享写入
- * 2. 原子早停信号：使用 stdatomic 通知所有线程停止
- * 3. 主线程归约：join 后取最小命中 UID
+ * 2. 动态分块调度：UID 范围切成升序小块，经原子游标分发，快核多领
+ * 3. 有序早停：块 k 命中后，所有编号大于 k 的块立即取消，仍保证最小 UID
+ * 4. 主线程归约：批次完成后取最小命中 UID
+ * 5. 线程复用：任务提交到常驻线程池 (thread_pool.c)，不再每个 Hash 建线程
  */
 
 #include <stdatomic.h>
@@ -14,15 +16,11 @@
 #include <stdlib.h>
 #include <string.h>
 
-#ifdef _WIN32
-#include <windows.h>
-#else
-#include <pthread.h>
-#endif
-
 #include "cracker.h"
 #include "crc32_core.h"
-#include "utils.h"
+#include "crc32_digits.h"
+#include "thread_pool.h"
+#include "uid_odometer.h"
 
 // ============== 配置常量 ==============
 #define MAX_THREADS 64
@@ -30,70 +28,146 @@
 #define MAX_UID                                                                \
   2200000000ULL // 限制在 Int32 范围内 (约22亿)，避免进入 11-13 位指数级陷阱
 
+#define CHUNK_SIZE 1000000ULL // 每个调度块 100 万 UID (全范围约 2200 块)
+#define CHUNK_COUNT ((MAX_UID + CHUNK_SIZE - 1) / CHUNK_SIZE)
+#define STOP_CHECK_INTERVAL 100000 // 块内每扫描 10 万个 UID 检查一次早停边界
+#define NO_HIT_CHUNK UINT64_MAX   // 尚无命中块
+
+// ============== 共享调度状态 ==============
+typedef struct {
+  atomic_ullong next_chunk; // 原子分发游标 (按块编号升序发放)
+  atomic_ullong best_chunk; // 已命中的最小块编号 (有序早停边界)
+} CrackSchedule;
+
 // ============== 线程上下文结构 ==============
 typedef struct {
-  uint64_t start_uid;   // 搜索起始UID
-  uint64_t end_uid;     // 搜索结束UID (不包含)
-  uint32_t target_hash; // 目标CRC32值
-  uint64_t result_uid;  // 线程本地结果，0表示未找到
-  int found;            // 线程本地标志
-  int thread_id;        // 线程编号 (用于调试)
+  CrackSchedule *sched;               // 共享调度器 (只读游标 + 原子边界)
+  uint32_t target_hash;               // 目标CRC32值
+  uint64_t result_uid;                // 线程本地最小结果，0表示未找到
+  int found;                          // 线程本地标志
+  int thread_id;                      // 线程编号 (用于调试)
 } ThreadContext;
 
-// ============== 全局原子停止信号 ==============
-static atomic_int g_stop_signal = 0;
-
-// ============== Windows 线程兼容层 ==============
-#ifdef _WIN32
-typedef HANDLE thread_t;
-typedef DWORD(WINAPI *thread_func_t)(void *);
-#define THREAD_CREATE(t, func, arg)                                            \
-  (*(t) =                                                                      \
-       CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)(func), (arg), 0, NULL),  \
-   *(t) != NULL ? 0 : -1)
-#define THREAD_JOIN(t) WaitForSingleObject(t, INFINITE)
-#else
-typedef pthread_t thread_t;
-typedef void *(*thread_func_t)(void *);
-#define THREAD_CREATE(t, func, arg) pthread_create(t, NULL, func, arg)
-#define THREAD_JOIN(t) pthread_join(t, NULL)
-#endif
+// 原子取最小值：将 best_chunk 降低到 chunk (若更小)
+static void schedule_mark_hit(CrackSchedule *sched, uint64_t chunk) {
+  unsigned long long cur = atomic_load(&sched->best_chunk);
+  while (chunk < cur &&
+         !atomic_compare_exchange_weak(&sched->best_chunk, &cur, chunk)) {
+  }
+}
+
+// 块 chunk 是否已被更小编号的命中块取消
+static inline int schedule_cancelled(CrackSchedule *sched, uint64_t chunk) {
+  return atomic_load(&sched->best_chunk) < chunk;
+}
+
+// 记录一次命中到线程本地上下文
+static void context_record_hit(ThreadContext *ctx, uint64_t uid) {
+  if (!ctx->found || uid < ctx->result_uid) {
+    ctx->result_uid = uid;
+  }
+  ctx->found = 1;
+}
+
+// ============== 块扫描函数 ==============
+// 扫描 [start, end)，返回 1 表示本块已结束 (命中或被取消)
+// 块内升序扫描，首个命中即本块最小值
+// start / end 均为 1000 的倍数：以 1000 个共享前缀的 UID 为一组，
+// 前缀由里程表增量推进，末 3 位交给 SIMD 尾部扫描 (crc32_digits.h)
+static int scan_chunk(ThreadContext *ctx, uint64_t chunk, uint64_t start,
+                      uint64_t end) {
+  CrackSchedule *sched = ctx->sched;
+  uint16_t tails[MAX_COLLISIONS];
+
+  // 0-999 的位数各不相同，不能共享前缀，逐个计算
+  if (start == 0) {
+    for (uint64_t uid = 0; uid < DIGITS_TAIL_SPAN; uid++) {
+      if (crc32_digits_eval(uid) == ctx->target_hash) {
+        context_record_hit(ctx, uid);
+        schedule_mark_hit(sched, chunk);
+        return 1;
+      }
+    }
+    start = DIGITS_TAIL_SPAN;
+  }
+
+  // 里程表枚举前缀 p = uid / 1000，进位时只重算变化的尾部数字
+  UidOdometer od;
+  uid_odometer_init(&od, start / DIGITS_TAIL_SPAN);
+
+  for (uint64_t base = start; base < end; base += STOP_CHECK_INTERVAL) {
+    // 更小编号的块已命中：本块内任何结果都不可能是最小 UID
+    if (schedule_cancelled(sched, chunk))
+      return 1;
+
+    uint64_t stop = base + STOP_CHECK_INTERVAL;
+    if (stop > end)
+      stop = end;
+
+    for (uint64_t uid = base; uid < stop; uid += DIGITS_TAIL_SPAN) {
+      // CRC(p * 1000)：前缀状态再推进 3 个 '0'
+      uint32_t s = od.state[od.len];
+      s = crc32_step(crc32_step(crc32_step(s, '0'), '0'), '0');
+
+      int n = crc32_digits_scan_tail(~s, ctx->target_hash, tails,
+                                     MAX_COLLISIONS);
+      if (n > 0) {
+        // 尾部按升序返回，首个即本块最小值
+        context_record_hit(ctx, uid + tails[0]);
+        schedule_mark_hit(sched, chunk);
+        return 1;
+      }
+      uid_odometer_next(&od);
+    }
+  }
+  return 0;
+}
 
 // ============== 工作线程函数 ==============
-#ifdef _WIN32
-static DWORD WINAPI worker_thread(void *arg) {
-#else
-static void *worker_thread(void *arg) {
-#endif
+static void worker_thread(void *arg) {
   ThreadContext *ctx = (ThreadContext *)arg;
-  char buf[16];
-  size_t len;
-
-  for (uint64_t uid = ctx->start_uid; uid < ctx->end_uid; uid++) {
-    // 不使用早停信号，确保每个线程都能找到自己范围内的第一个匹配
-    // 这样才能保证归约时得到全局最小的 UID（处理 CRC32 碰撞）
-
-    // 将UID转换为字符串
-    len = fast_uid_to_str(uid, buf);
-
-    // 计算CRC32并匹配
-    if (crc32_fast(buf, len) == ctx->target_hash) {
-      ctx->result_uid = uid;
-      ctx->found = 1;
-      // 找到第一个匹配后立即退出本线程（不通知其他线程）
-#ifdef _WIN32
-      return 0;
-#else
-      return NULL;
-#endif
-    }
+  CrackSchedule *sched = ctx->sched;
+
+  for (;;) {
+    uint64_t chunk = atomic_fetch_add(&sched->next_chunk, 1);
+    if (chunk >= CHUNK_COUNT)
+      return;
+
+    // 游标单调递增：之后领取的块只会更大，可直接退出
+    if (schedule_cancelled(sched, chunk))
+      return;
+
+    uint64_t start = chunk * CHUNK_SIZE;
+    uint64_t end = start + CHUNK_SIZE;
+    if (end > MAX_UID)
+      end = MAX_UID;
+
+    scan_chunk(ctx, chunk, start, end);
+  }
+}
+
+// 初始化调度器与线程上下文并提交到线程池
+static int run_crack_job(uint32_t target, int thread_count,
+                         CrackSchedule *sched, ThreadContext *contexts) {
+  atomic_store(&sched->next_chunk, 0);
+  atomic_store(&sched->best_chunk, NO_HIT_CHUNK);
+  crc32_digits_init(); // 尾部扫描表需在工作线程启动前就绪
+
+  for (int i = 0; i < thread_count; i++) {
+    contexts[i].sched = sched;
+    contexts[i].target_hash = target;
+    contexts[i].result_uid = 0;
+    contexts[i].found = 0;
+    contexts[i].thread_id = i;
   }
 
-#ifdef _WIN32
+  // 提交到常驻线程池并等待所有任务完成
+  if (thread_pool_run(worker_thread, contexts, sizeof(ThreadContext),
+                      thread_count) != 0) {
+    fprintf(stderr, "[Error] 线程池任务提交失败\n");
+    return -1;
+  }
   return 0;
-#else
-  return NULL;
-#endif
 }
 
 // ============== 主入口函数 ==============
@@ -109,46 +183,13 @@ uint64_t crack_hash(const char *hex_hash, int thread_count) {
   printf("[Core] 启动 %d 线程爆破 Hash: %08x (范围: 0-%I64u)\n", thread_count,
          target, MAX_UID);
 
-  // 重置全局停止信号
-  atomic_store(&g_stop_signal, 0);
-
-  // 分配线程上下文数组
+  // 分配调度器与线程上下文数组
+  CrackSchedule sched;
   ThreadContext contexts[MAX_THREADS];
-  thread_t threads[MAX_THREADS];
-
-  // 计算每个线程的搜索范围
-  uint64_t chunk_size = MAX_UID / thread_count;
-  uint64_t remainder = MAX_UID % thread_count;
 
-  for (int i = 0; i < thread_count; i++) {
-    contexts[i].start_uid = i * chunk_size;
-    contexts[i].end_uid = (i + 1) * chunk_size;
-    if (i == thread_count - 1) {
-      contexts[i].end_uid += remainder; // 最后一个线程处理余数
-    }
-    contexts[i].target_hash = target;
-    contexts[i].result_uid = 0;
-    contexts[i].found = 0;
-    contexts[i].thread_id = i;
-
-    // 创建线程
-    if (THREAD_CREATE(&threads[i], worker_thread, &contexts[i]) != 0) {
-      fprintf(stderr, "[Error] 无法创建线程 %d\n", i);
-      // 等待已创建的线程
-      for (int j = 0; j < i; j++) {
-        THREAD_JOIN(threads[j]);
-      }
-      return 0;
-    }
-  }
-
-  // 进度显示线程 (可选，简化实现)
-  printf("[Progress] 所有线程已启动，等待结果...\n");
-
-  // 等待所有线程完成
-  for (int i = 0; i < thread_count; i++) {
-    THREAD_JOIN(threads[i]);
-  }
+  printf("[Progress] 任务已提交线程池，等待结果...\n");
+  if (run_crack_job(target, thread_count, &sched, contexts) != 0)
+    return 0;
 
   // 主线程归约：找最小命中UID
   uint64_t result = 0;
@@ -169,79 +210,81 @@ uint64_t crack_hash(const char *hex_hash, int thread_count) {
   return result;
 }
 
-// ============== 全量碰撞扫描函数 ==============
-int crack_hash_all(const char *hex_hash, int thread_count, CrackResult *out) {
+// ============== 尾部反演破解 ==============
+// CRC32 每步推进: s' = (s >> 8) ^ T[(s ^ b) & 0xFF]
+// T 的最高字节唯一，故由最终状态可逐步反推出最后 4 步的查表下标 idx[0..3]，
+// 与前缀状态无关；再结合前缀状态正向求出 4 个字节 b = idx ^ (s & 0xFF)。
+#define INVERT_TAIL_SPAN 10000ULL // 10^4
+
+// 由目标 CRC 反推最后 4 步的查表下标
+static void invert_tail_indices(uint32_t target, uint8_t idx[4]) {
+  uint32_t s = ~target; // 最终内部状态
+  for (int k = 3; k >= 0; k--) {
+    idx[k] = crc32_rev_table[s >> 24];
+    s = (s ^ crc32_table[idx[k]]) << 8; // 低字节未知，仅高位有效
+  }
+}
+
+// 从前缀状态正向求出 4 个尾部字符，全部为数字时返回其数值，否则返回 -1
+static inline int invert_tail_value(uint32_t prefix_state,
+                                    const uint8_t idx[4]) {
+  uint32_t s = prefix_state;
+  int value = 0;
+  for (int k = 0; k < 4; k++) {
+    uint8_t b = idx[k] ^ (uint8_t)s;
+    if (b < '0' || b > '9')
+      return -1;
+    value = value * 10 + (b - '0');
+    s = (s >> 8) ^ crc32_table[idx[k]];
+  }
+  return value;
+}
+
+static void invert_record(CrackResult *out, uint64_t uid) {
+  if (out->count < MAX_COLLISIONS) {
+    out->uids[out->count++] = uid;
+  }
+}
+
+int crack_hash_invert(const char *hex_hash, CrackResult *out) {
   if (!out)
     return 0;
 
-  // 初始化输出
   out->count = 0;
   for (int i = 0; i < MAX_COLLISIONS; i++) {
     out->uids[i] = 0;
   }
 
-  // 参数校验与默认值
-  if (thread_count <= 0 || thread_count > MAX_THREADS) {
-    thread_count = DEFAULT_THREADS;
-  }
-
-  // 将16进制字符串转换为整数
   uint32_t target = (uint32_t)strtoul(hex_hash, NULL, 16);
-
-  printf("[Core] 全量碰撞扫描 Hash: %08x (范围: 0-%I64u)\n", target, MAX_UID);
-
-  // 重置全局停止信号
-  atomic_store(&g_stop_signal, 0);
-
-  // 分配线程上下文数组
-  ThreadContext contexts[MAX_THREADS];
-  thread_t threads[MAX_THREADS];
-
-  // 计算每个线程的搜索范围
-  uint64_t chunk_size = MAX_UID / thread_count;
-  uint64_t remainder = MAX_UID % thread_count;
-
-  for (int i = 0; i < thread_count; i++) {
-    contexts[i].start_uid = i * chunk_size;
-    contexts[i].end_uid = (i + 1) * chunk_size;
-    if (i == thread_count - 1) {
-      contexts[i].end_uid += remainder;
-    }
-    contexts[i].target_hash = target;
-    contexts[i].result_uid = 0;
-    contexts[i].found = 0;
-    contexts[i].thread_id = i;
-
-    if (THREAD_CREATE(&threads[i], worker_thread, &contexts[i]) != 0) {
-      fprintf(stderr, "[Error] 无法创建线程 %d\n", i);
-      for (int j = 0; j < i; j++) {
-        THREAD_JOIN(threads[j]);
-      }
-      return 0;
-    }
-  }
-
-  // 等待所有线程完成
-  for (int i = 0; i < thread_count; i++) {
-    THREAD_JOIN(threads[i]);
+  printf("[Core] 尾部反演扫描 Hash: %08x (范围: 0-%I64u)\n", target, MAX_UID);
+
+  uint8_t idx[4];
+  invert_tail_indices(target, idx);
+
+  // 1. 1-3 位 UID：不足 4 个字符，直接枚举
+  UidOdometer od;
+  uid_odometer_init(&od, 0);
+  for (uint64_t uid = 0; uid < 1000; uid++) {
+    if (uid_odometer_crc(&od) == target)
+      invert_record(out, uid);
+    uid_odometer_next(&od);
   }
 
-  // 收集所有碰撞候选（每个线程最多贡献1个，因为当前实现找到第一个就退出）
-  for (int i = 0; i < thread_count; i++) {
-    if (contexts[i].found && out->count < MAX_COLLISIONS) {
-      out->uids[out->count++] = contexts[i].result_uid;
-    }
-  }
-
-  // 按UID升序排序
-  for (int i = 0; i < out->count - 1; i++) {
-    for (int j = i + 1; j < out->count; j++) {
-      if (out->uids[j] < out->uids[i]) {
-        uint64_t tmp = out->uids[i];
-        out->uids[i] = out->uids[j];
-        out->uids[j] = tmp;
-      }
+  // 2. 4 位 UID：空前缀，尾部即完整字符串 (首位不能为 0)
+  int tail = invert_tail_value(0xFFFFFFFF, idx);
+  if (tail >= 1000)
+    invert_record(out, (uint64_t)tail);
+
+  // 3. 5 位及以上：枚举 n-4 位前缀，按升序自然覆盖所有长度
+  uid_odometer_init(&od, 1);
+  for (uint64_t prefix = 1; prefix * INVERT_TAIL_SPAN < MAX_UID; prefix++) {
+    tail = invert_tail_value(od.state[od.len], idx);
+    if (tail >= 0) {
+      uint64_t uid = prefix * INVERT_TAIL_SPAN + (uint64_t)tail;
+      if (uid < MAX_UID)
+        invert_record(out, uid);
     }
+    uid_odometer_next(&od);
   }
 
   printf("[Core] 找到 %d 个碰撞候选\n", out->count);
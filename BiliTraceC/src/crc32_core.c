@@ -0,0 +1,394 @@
+/**
+ * crc32_core.c
+ * CRC32 扩展查表核与调度实现
+ *
+ * Slicing-by-N: 预先生成 N 张 256 项表，table[k][i] 表示字节 i 之后再跟
+ * k 个零字节时对 CRC 的贡献，一次处理 N 个字节，打断逐字节的依赖链。
+ * 长度很短时扩展表的额外开销不划算，因此默认按长度分段选择计算核；
+ * 大块数据在支持 PCLMULQDQ 的 CPU 上走折叠路径 (crc32_clmul.c，实验性：
+ * 项目内实际计算的都是短数字串，目前仅基准测试会用到)。
+ */
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "crc32_core.h"
+#include "crc32_digits.h"
+
+// ============== 配置 ==============
+#define SLICE_MAX 16
+#define AUTO_SLICE8_MIN_LEN 8   // >= 8 字节启用 Slicing-by-8
+#define AUTO_SLICE16_MIN_LEN 16 // >= 16 字节启用 Slicing-by-16
+#define AUTO_CLMUL_MIN_LEN 64   // >= 64 字节启用 PCLMULQDQ 折叠
+
+// ============== 全局状态 ==============
+static uint32_t g_slice_table[SLICE_MAX][256]; // [0] 与 crc32_table 相同
+// 初始化状态：0=未开始, 1=进行中, 2=已就绪 (release 发布，读取方 acquire)
+static atomic_int g_slice_state = 0;
+static int g_clmul_ok = 0; // CPUID 检测结果
+static Crc32Kernel g_kernel = CRC32_KERNEL_AUTO;
+
+static inline int slice_ready(void) {
+  return atomic_load_explicit(&g_slice_state, memory_order_acquire) == 2;
+}
+
+void crc32_init(void) {
+  if (slice_ready())
+    return;
+  int expected = 0;
+  if (!atomic_compare_exchange_strong(&g_slice_state, &expected, 1)) {
+    // 其他线程正在生成：等待其发布 (只有几十 KB 的表，很快完成)
+    while (!slice_ready())
+      ;
+    return;
+  }
+
+  for (int i = 0; i < 256; i++) {
+    g_slice_table[0][i] = crc32_table[i];
+  }
+  for (int k = 1; k < SLICE_MAX; k++) {
+    for (int i = 0; i < 256; i++) {
+      uint32_t prev = g_slice_table[k - 1][i];
+      g_slice_table[k][i] = (prev >> 8) ^ crc32_table[prev & 0xFF];
+    }
+  }
+  g_clmul_ok = crc32_clmul_available();
+  crc32_digits_init();
+  atomic_store_explicit(&g_slice_state, 2, memory_order_release);
+}
+
+// 小端读取 32 位 (与字节序无关，编译器会合并为单次加载)
+static inline uint32_t load_le32(const uint8_t *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+         ((uint32_t)p[3] << 24);
+}
+
+// ============== 计算核 ==============
+
+static uint32_t update_sarwate(uint32_t crc, const uint8_t *p, size_t len) {
+  while (len--) {
+    crc = crc32_step(crc, *p++);
+  }
+  return crc;
+}
+
+static uint32_t update_slice8(uint32_t crc, const uint8_t *p, size_t len) {
+  const uint32_t(*t)[256] = g_slice_table;
+  while (len >= 8) {
+    uint32_t one = load_le32(p) ^ crc;
+    uint32_t two = load_le32(p + 4);
+    crc = t[7][one & 0xFF] ^ t[6][(one >> 8) & 0xFF] ^
+          t[5][(one >> 16) & 0xFF] ^ t[4][one >> 24] ^ t[3][two & 0xFF] ^
+          t[2][(two >> 8) & 0xFF] ^ t[1][(two >> 16) & 0xFF] ^ t[0][two >> 24];
+    p += 8;
+    len -= 8;
+  }
+  return update_sarwate(crc, p, len);
+}
+
+static uint32_t update_slice16(uint32_t crc, const uint8_t *p, size_t len) {
+  const uint32_t(*t)[256] = g_slice_table;
+  while (len >= 16) {
+    uint32_t one = load_le32(p) ^ crc;
+    uint32_t two = load_le32(p + 4);
+    uint32_t three = load_le32(p + 8);
+    uint32_t four = load_le32(p + 12);
+    crc = t[15][one & 0xFF] ^ t[14][(one >> 8) & 0xFF] ^
+          t[13][(one >> 16) & 0xFF] ^ t[12][one >> 24] ^ t[11][two & 0xFF] ^
+          t[10][(two >> 8) & 0xFF] ^ t[9][(two >> 16) & 0xFF] ^
+          t[8][two >> 24] ^ t[7][three & 0xFF] ^ t[6][(three >> 8) & 0xFF] ^
+          t[5][(three >> 16) & 0xFF] ^ t[4][three >> 24] ^ t[3][four & 0xFF] ^
+          t[2][(four >> 8) & 0xFF] ^ t[1][(four >> 16) & 0xFF] ^
+          t[0][four >> 24];
+    p += 16;
+    len -= 16;
+  }
+  return update_slice8(crc, p, len);
+}
+
+// ============== 调度入口 ==============
+
+uint32_t crc32_update(uint32_t crc, const void *buf, size_t len) {
+  const uint8_t *p = (const uint8_t *)buf;
+
+  if (len < AUTO_SLICE8_MIN_LEN && g_kernel == CRC32_KERNEL_AUTO)
+    return update_sarwate(crc, p, len);
+
+  if (!slice_ready())
+    crc32_init();
+
+  switch (g_kernel) {
+  case CRC32_KERNEL_SARWATE:
+    return update_sarwate(crc, p, len);
+  case CRC32_KERNEL_SLICE8:
+    return update_slice8(crc, p, len);
+  case CRC32_KERNEL_SLICE16:
+    return update_slice16(crc, p, len);
+  case CRC32_KERNEL_CLMUL:
+    return g_clmul_ok ? crc32_update_clmul(crc, p, len)
+                      : update_slice16(crc, p, len);
+  default:
+    break;
+  }
+
+  // AUTO: 按长度分段
+  if (len < AUTO_SLICE16_MIN_LEN)
+    return update_slice8(crc, p, len);
+  if (len >= AUTO_CLMUL_MIN_LEN && g_clmul_ok)
+    return crc32_update_clmul(crc, p, len);
+  return update_slice16(crc, p, len);
+}
+
+void crc32_batch_fixed(const void *data, size_t stride, size_t len,
+                       size_t count, uint32_t *out) {
+  const uint8_t *p = (const uint8_t *)data;
+
+  if (!slice_ready())
+    crc32_init();
+
+  if (len >= 8 && g_clmul_ok &&
+      (g_kernel == CRC32_KERNEL_AUTO || g_kernel == CRC32_KERNEL_CLMUL)) {
+    crc32_batch_fixed_clmul(p, stride, len, count, out);
+    return;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    out[i] = ~crc32_update(0xFFFFFFFF, p + i * stride, len);
+  }
+}
+
+void crc32_select_kernel(Crc32Kernel kernel) {
+  if ((int)kernel < 0 || kernel >= CRC32_KERNEL_COUNT)
+    kernel = CRC32_KERNEL_AUTO;
+  crc32_init();
+  g_kernel = kernel;
+}
+
+const char *crc32_kernel_name(Crc32Kernel kernel) {
+  switch (kernel) {
+  case CRC32_KERNEL_AUTO:
+    return "auto";
+  case CRC32_KERNEL_SARWATE:
+    return "sarwate";
+  case CRC32_KERNEL_SLICE8:
+    return "slice8";
+  case CRC32_KERNEL_SLICE16:
+    return "slice16";
+  case CRC32_KERNEL_CLMUL:
+    return "clmul";
+  default:
+    return "unknown";
+  }
+}
+
+// ============== 移位算子 ==============
+#define CRC32_POLY 0xEDB88320u
+
+// GF(2) 多项式乘法 a * b mod P (反射位序：x^0 在最高位，a 不能为 0)
+static uint32_t multmodp(uint32_t a, uint32_t b) {
+  uint32_t m = 1u << 31;
+  uint32_t p = 0;
+  for (;;) {
+    if (a & m) {
+      p ^= b;
+      if ((a & (m - 1)) == 0)
+        break;
+    }
+    m >>= 1;
+    b = (b & 1) ? (b >> 1) ^ CRC32_POLY : b >> 1;
+  }
+  return p;
+}
+
+// x^(8 * len) mod P：按 len 的二进制位累乘 x^(8 * 2^k)
+static uint32_t x8nmodp(uint64_t len) {
+  uint32_t p = 1u << 31;  // x^0
+  uint32_t sq = 1u << 23; // x^8
+  while (len) {
+    if (len & 1)
+      p = multmodp(sq, p);
+    sq = multmodp(sq, sq);
+    len >>= 1;
+  }
+  return p;
+}
+
+void crc32_shift_op_init(Crc32ShiftOp *op, uint64_t len) {
+  uint32_t xn = x8nmodp(len);
+  op->len = len;
+  for (int k = 0; k < 4; k++) {
+    for (uint32_t b = 0; b < 256; b++) {
+      op->table[k][b] = b ? multmodp(xn, b << (8 * k)) : 0;
+    }
+  }
+}
+
+// ============== 基准测试 ==============
+#define BENCH_MAX_LEN 19       // 项目实际哈希的最长输入 (19 位数字)
+#define BENCH_SAMPLES 1024     // 轮换使用的样本串数量
+#define BENCH_ITERATIONS 4000000
+#define BENCH_BULK_BYTES (64 * 1024 * 1024) // 大块数据每轮处理的总字节数
+#define BENCH_BATCH_KEYS (1 << 16)          // 批量路径每轮的 8 字节键数量
+#define BENCH_BATCH_ROUNDS 64
+
+// 大块数据吞吐 (模拟整个 .pb 分段文件的校验)
+static void bench_bulk(void) {
+  static const size_t sizes[] = {64, 1024, 65536};
+  size_t max_size = sizes[sizeof(sizes) / sizeof(sizes[0]) - 1];
+  uint8_t *buf = (uint8_t *)malloc(max_size);
+  if (!buf)
+    return;
+  for (size_t i = 0; i < max_size; i++) {
+    buf[i] = (uint8_t)(i * 131 + 7);
+  }
+
+  // 正确性自检：折叠路径必须与逐字节结果一致
+  for (size_t len = 0; len <= max_size; len = len * 2 + 37) {
+    uint32_t ref = update_sarwate(0xFFFFFFFF, buf, len);
+    if (g_clmul_ok && crc32_update_clmul(0xFFFFFFFF, buf, len) != ref) {
+      printf("[Bench] PCLMULQDQ 路径在长度 %zu 上结果错误！\n", len);
+    }
+  }
+
+  printf("[Bench] 大块数据吞吐 (GB/s, PCLMULQDQ %s)\n",
+         g_clmul_ok ? "可用" : "不可用");
+  printf("  size");
+  for (int k = CRC32_KERNEL_SARWATE; k < CRC32_KERNEL_COUNT; k++) {
+    printf(" %9s", crc32_kernel_name((Crc32Kernel)k));
+  }
+  printf("\n");
+
+  volatile uint32_t sink = 0;
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    size_t rounds = BENCH_BULK_BYTES / sizes[s];
+    printf("  %5zu", sizes[s]);
+    for (int k = CRC32_KERNEL_SARWATE; k < CRC32_KERNEL_COUNT; k++) {
+      g_kernel = (Crc32Kernel)k;
+      uint32_t acc = 0;
+      clock_t start = clock();
+      for (size_t r = 0; r < rounds; r++) {
+        acc ^= crc32_update(0xFFFFFFFF, buf, sizes[s]);
+      }
+      clock_t end = clock();
+      sink ^= acc;
+      double sec = (double)(end - start) / CLOCKS_PER_SEC;
+      printf(" %9.2f", sec > 0 ? BENCH_BULK_BYTES / sec / 1e9 : 0.0);
+    }
+    printf("\n");
+  }
+  (void)sink;
+  free(buf);
+}
+
+// 批量 8 字节键 (MITM 建表的输入形态)
+static void bench_batch(void) {
+  char *keys = (char *)malloc((size_t)BENCH_BATCH_KEYS * 8);
+  uint32_t *out = (uint32_t *)malloc(sizeof(uint32_t) * BENCH_BATCH_KEYS);
+  if (!keys || !out) {
+    free(keys);
+    free(out);
+    return;
+  }
+  for (int i = 0; i < BENCH_BATCH_KEYS; i++) {
+    char tmp[9]; // 定长键不含结尾 '\0'，先格式化到临时区
+    snprintf(tmp, sizeof(tmp), "%08d", i * 1523);
+    memcpy(keys + (size_t)i * 8, tmp, 8);
+  }
+
+  // 正确性自检
+  crc32_batch_fixed(keys, 8, 8, BENCH_BATCH_KEYS, out);
+  for (int i = 0; i < BENCH_BATCH_KEYS; i++) {
+    if (out[i] != crc32_fast(keys + (size_t)i * 8, 8)) {
+      printf("[Bench] 批量路径结果错误 (key %d)！\n", i);
+      break;
+    }
+  }
+
+  volatile uint32_t sink = 0;
+  clock_t start = clock();
+  for (int r = 0; r < BENCH_BATCH_ROUNDS; r++) {
+    for (int i = 0; i < BENCH_BATCH_KEYS; i++) {
+      sink ^= crc32_fast(keys + (size_t)i * 8, 8);
+    }
+  }
+  double scalar = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+  start = clock();
+  for (int r = 0; r < BENCH_BATCH_ROUNDS; r++) {
+    crc32_batch_fixed(keys, 8, 8, BENCH_BATCH_KEYS, out);
+    sink ^= out[r];
+  }
+  double batch = (double)(clock() - start) / CLOCKS_PER_SEC;
+  (void)sink;
+
+  double n = (double)BENCH_BATCH_KEYS * BENCH_BATCH_ROUNDS;
+  printf("[Bench] 8 字节键批量哈希: 逐个 %.2f ns/键, 批量 %.2f ns/键\n",
+         scalar * 1e9 / n, batch * 1e9 / n);
+
+  free(keys);
+  free(out);
+}
+
+void crc32_benchmark(void) {
+  static char samples[BENCH_SAMPLES][BENCH_MAX_LEN];
+  Crc32Kernel saved = g_kernel;
+
+  crc32_init();
+
+  // 生成伪随机数字串，避免分支预测器记住固定输入
+  uint32_t seed = 0x12345678;
+  for (int i = 0; i < BENCH_SAMPLES; i++) {
+    for (int j = 0; j < BENCH_MAX_LEN; j++) {
+      seed = seed * 1103515245 + 12345;
+      samples[i][j] = (char)('0' + (seed >> 16) % 10);
+    }
+  }
+
+  // 正确性自检：所有计算核结果必须一致
+  for (size_t len = 1; len <= BENCH_MAX_LEN; len++) {
+    uint32_t ref = update_sarwate(0xFFFFFFFF, (const uint8_t *)samples[0], len);
+    for (int k = CRC32_KERNEL_AUTO; k < CRC32_KERNEL_COUNT; k++) {
+      g_kernel = (Crc32Kernel)k;
+      if (crc32_update(0xFFFFFFFF, samples[0], len) != ref) {
+        printf("[Bench] 计算核 %s 在长度 %zu 上结果错误！\n",
+               crc32_kernel_name((Crc32Kernel)k), len);
+      }
+    }
+  }
+
+  printf("[Bench] CRC32 计算核对比 (ns/次, %d 次迭代)\n", BENCH_ITERATIONS);
+  printf("  len");
+  for (int k = CRC32_KERNEL_AUTO; k < CRC32_KERNEL_COUNT; k++) {
+    printf(" %9s", crc32_kernel_name((Crc32Kernel)k));
+  }
+  printf("\n");
+
+  volatile uint32_t sink = 0;
+  for (size_t len = 1; len <= BENCH_MAX_LEN; len++) {
+    printf("  %3zu", len);
+    for (int k = CRC32_KERNEL_AUTO; k < CRC32_KERNEL_COUNT; k++) {
+      g_kernel = (Crc32Kernel)k;
+      uint32_t acc = 0;
+      clock_t start = clock();
+      for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        acc ^= crc32_update(0xFFFFFFFF, samples[i & (BENCH_SAMPLES - 1)], len);
+      }
+      clock_t end = clock();
+      sink ^= acc;
+      double ns = (double)(end - start) * 1e9 / CLOCKS_PER_SEC /
+                  BENCH_ITERATIONS;
+      printf(" %9.2f", ns);
+    }
+    printf("\n");
+  }
+  (void)sink;
+
+  bench_bulk();
+  g_kernel = CRC32_KERNEL_AUTO;
+  bench_batch();
+
+  g_kernel = saved;
+}
@@ -0,0 +1,307 @@
+/**
+ * crc32_digits.c
+ * 数字贡献异或表与 SIMD 批量求值实现
+ *
+ * 设计原则：
+ * 1. 贡献表只有 19 x 10 项 + 20 个长度常数，常驻 L1 缓存
+ * 2. 尾部 1000 项组合表 (末 3 位) 把候选求值化为一次异或 + 比较
+ * 3. AVX2 / SSE2 运行时选择，其余平台退回标量实现
+ */
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "crc32_core.h"
+#include "crc32_digits.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define DIGITS_HAVE_X86 1
+#include <immintrin.h>
+#define AVX2_TARGET __attribute__((target("avx2")))
+#elif defined(_MSC_VER) && defined(_M_X64)
+#define DIGITS_HAVE_X86 1
+#include <immintrin.h>
+#include <intrin.h>
+#define AVX2_TARGET
+#else
+#define DIGITS_HAVE_X86 0
+#endif
+
+// ============== 全局状态 ==============
+static Crc32DigitTables g_tables;
+static _Alignas(32) uint32_t g_tail[DIGITS_TAIL_SPAN]; // 末 3 位组合贡献
+// 初始化状态：0=未开始, 1=进行中, 2=已就绪 (release 发布，读取方 acquire)
+static atomic_int g_digits_state = 0;
+static int g_has_avx2 = 0;
+
+static const uint64_t g_pow10[DIGITS_MAX_LEN + 1] = {
+    1ULL,
+    10ULL,
+    100ULL,
+    1000ULL,
+    10000ULL,
+    100000ULL,
+    1000000ULL,
+    10000000ULL,
+    100000000ULL,
+    1000000000ULL,
+    10000000000ULL,
+    100000000000ULL,
+    1000000000000ULL,
+    10000000000000ULL,
+    100000000000000ULL,
+    1000000000000000ULL,
+    10000000000000000ULL,
+    100000000000000000ULL,
+    1000000000000000000ULL,
+    10000000000000000000ULL};
+
+static int detect_avx2(void) {
+#if DIGITS_HAVE_X86 && defined(__GNUC__)
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+#elif DIGITS_HAVE_X86
+  int regs[4];
+  __cpuid(regs, 1);
+  // OSXSAVE (bit 27) + AVX (bit 28)，并确认操作系统保存 YMM 状态
+  if (!((regs[2] >> 27) & 1) || !((regs[2] >> 28) & 1))
+    return 0;
+  if ((_xgetbv(0) & 0x6) != 0x6)
+    return 0;
+  __cpuidex(regs, 7, 0);
+  return (regs[1] >> 5) & 1;
+#else
+  return 0;
+#endif
+}
+
+static inline int digits_ready(void) {
+  return atomic_load_explicit(&g_digits_state, memory_order_acquire) == 2;
+}
+
+void crc32_digits_init(void) {
+  if (digits_ready())
+    return;
+  int expected = 0;
+  if (!atomic_compare_exchange_strong(&g_digits_state, &expected, 1)) {
+    // 其他线程正在生成：等待其发布 (表只有几 KB，很快完成)
+    while (!digits_ready())
+      ;
+    return;
+  }
+
+  // base[n] = CRC("0" * n)
+  uint32_t state = 0xFFFFFFFF;
+  g_tables.base[0] = 0;
+  for (int n = 1; n <= DIGITS_MAX_LEN; n++) {
+    state = crc32_step(state, '0');
+    g_tables.base[n] = ~state;
+  }
+
+  // contrib[j][d]: 线性部分 (初值 0、无最终异或) 中，
+  // 字节 ('0' + d) ^ '0' = d 之后再跟 j 个零字节的贡献
+  for (int d = 0; d < 10; d++) {
+    uint32_t c = crc32_table[d];
+    for (int j = 0; j < DIGITS_MAX_LEN; j++) {
+      g_tables.contrib[j][d] = c;
+      c = crc32_step(c, 0);
+    }
+  }
+
+  for (int t = 0; t < DIGITS_TAIL_SPAN; t++) {
+    g_tail[t] = g_tables.contrib[2][t / 100] ^
+                g_tables.contrib[1][(t / 10) % 10] ^ g_tables.contrib[0][t % 10];
+  }
+
+  g_has_avx2 = detect_avx2();
+  atomic_store_explicit(&g_digits_state, 2, memory_order_release);
+}
+
+const Crc32DigitTables *crc32_digits_tables(void) {
+  if (!digits_ready())
+    crc32_digits_init();
+  return &g_tables;
+}
+
+// ============== 标量求值 ==============
+
+uint32_t crc32_digits_eval(uint64_t value) {
+  if (!digits_ready())
+    crc32_digits_init();
+
+  uint32_t crc = 0;
+  int len = 0;
+  do {
+    crc ^= g_tables.contrib[len][value % 10];
+    value /= 10;
+    len++;
+  } while (value);
+  return crc ^ g_tables.base[len];
+}
+
+static inline int count_digits(uint64_t value) {
+  int len = 1;
+  while (len < DIGITS_MAX_LEN + 1 && value >= g_pow10[len])
+    len++;
+  return len;
+}
+
+// ============== AVX2 批量求值 ==============
+#if DIGITS_HAVE_X86
+
+// 8 路 32 位无符号除以 10 (乘法逆元 0xCCCCCCCD >> 35)
+AVX2_TARGET static inline __m256i div10_epu32(__m256i x) {
+  const __m256i magic = _mm256_set1_epi32((int)0xCCCCCCCD);
+  __m256i even = _mm256_srli_epi64(_mm256_mul_epu32(x, magic), 35);
+  __m256i odd = _mm256_srli_epi64(
+      _mm256_mul_epu32(_mm256_srli_epi64(x, 32), magic), 35);
+  return _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+}
+
+// 将 8 个 32 位分段 (每段至多 8 位数字) 的贡献异或进 acc
+AVX2_TARGET static inline __m256i accumulate_limb(__m256i acc, __m256i x,
+                                                  int first_pos, int digits) {
+  const int *table = (const int *)&g_tables.contrib[0][0];
+  const __m256i ten = _mm256_set1_epi32(10);
+  for (int p = 0; p < digits; p++) {
+    __m256i q = div10_epu32(x);
+    __m256i d = _mm256_sub_epi32(x, _mm256_mullo_epi32(q, ten));
+    __m256i idx = _mm256_add_epi32(d, _mm256_set1_epi32((first_pos + p) * 10));
+    acc = _mm256_xor_si256(acc, _mm256_i32gather_epi32(table, idx, 4));
+    x = q;
+  }
+  return acc;
+}
+
+AVX2_TARGET static void eval_batch_avx2(const uint64_t *values, size_t count,
+                                        uint32_t *out) {
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    // 标量拆分为 3 个 10^8 进制分段，并查出各自的长度常数
+    uint32_t lo[8], mid[8], hi[8], base[8];
+    for (int k = 0; k < 8; k++) {
+      uint64_t v = values[i + k];
+      lo[k] = (uint32_t)(v % 100000000ULL);
+      v /= 100000000ULL;
+      mid[k] = (uint32_t)(v % 100000000ULL);
+      hi[k] = (uint32_t)(v / 100000000ULL);
+      base[k] = g_tables.base[count_digits(values[i + k])];
+    }
+
+    __m256i acc = _mm256_loadu_si256((const __m256i *)base);
+    acc = accumulate_limb(acc, _mm256_loadu_si256((const __m256i *)lo), 0, 8);
+
+    // 高位分段全为 0 时贡献为 0 (contrib[j][0] == 0)，可整段跳过
+    __m256i vmid = _mm256_loadu_si256((const __m256i *)mid);
+    if (!_mm256_testz_si256(vmid, vmid))
+      acc = accumulate_limb(acc, vmid, 8, 8);
+    __m256i vhi = _mm256_loadu_si256((const __m256i *)hi);
+    if (!_mm256_testz_si256(vhi, vhi))
+      acc = accumulate_limb(acc, vhi, 16, DIGITS_MAX_LEN - 16);
+
+    _mm256_storeu_si256((__m256i *)(out + i), acc);
+  }
+
+  for (; i < count; i++) {
+    out[i] = crc32_digits_eval(values[i]);
+  }
+}
+
+// ============== 尾部扫描 (AVX2 / SSE2) ==============
+
+AVX2_TARGET static int scan_tail_avx2(uint32_t want, uint16_t *hits,
+                                      int max_hits) {
+  const __m256i vwant = _mm256_set1_epi32((int)want);
+  int count = 0;
+  int t = 0;
+
+  // 每轮 16 个候选
+  for (; t + 16 <= DIGITS_TAIL_SPAN; t += 16) {
+    __m256i a = _mm256_cmpeq_epi32(
+        _mm256_load_si256((const __m256i *)(g_tail + t)), vwant);
+    __m256i b = _mm256_cmpeq_epi32(
+        _mm256_load_si256((const __m256i *)(g_tail + t + 8)), vwant);
+    __m256i any = _mm256_or_si256(a, b);
+    if (_mm256_testz_si256(any, any))
+      continue;
+
+    unsigned mask =
+        (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(a)) |
+        ((unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(b)) << 8);
+    for (int k = 0; k < 16; k++) {
+      if (((mask >> k) & 1) && count < max_hits)
+        hits[count++] = (uint16_t)(t + k);
+    }
+  }
+
+  for (; t < DIGITS_TAIL_SPAN; t++) {
+    if (g_tail[t] == want && count < max_hits)
+      hits[count++] = (uint16_t)t;
+  }
+  return count;
+}
+
+static int scan_tail_sse2(uint32_t want, uint16_t *hits, int max_hits) {
+  const __m128i vwant = _mm_set1_epi32((int)want);
+  int count = 0;
+  int t = 0;
+
+  for (; t + 4 <= DIGITS_TAIL_SPAN; t += 4) {
+    __m128i eq = _mm_cmpeq_epi32(_mm_load_si128((const __m128i *)(g_tail + t)),
+                                 vwant);
+    unsigned mask = (unsigned)_mm_movemask_ps(_mm_castsi128_ps(eq));
+    if (!mask)
+      continue;
+    for (int k = 0; k < 4; k++) {
+      if (((mask >> k) & 1) && count < max_hits)
+        hits[count++] = (uint16_t)(t + k);
+    }
+  }
+
+  for (; t < DIGITS_TAIL_SPAN; t++) {
+    if (g_tail[t] == want && count < max_hits)
+      hits[count++] = (uint16_t)t;
+  }
+  return count;
+}
+
+#endif // DIGITS_HAVE_X86
+
+// ============== 公共接口 ==============
+
+void crc32_digits_eval_batch(const uint64_t *values, size_t count,
+                             uint32_t *out) {
+  if (!digits_ready())
+    crc32_digits_init();
+
+#if DIGITS_HAVE_X86
+  if (g_has_avx2) {
+    eval_batch_avx2(values, count, out);
+    return;
+  }
+#endif
+
+  for (size_t i = 0; i < count; i++) {
+    out[i] = crc32_digits_eval(values[i]);
+  }
+}
+
+int crc32_digits_scan_tail(uint32_t prefix_crc, uint32_t target,
+                           uint16_t *hits, int max_hits) {
+  // CRC(p * 1000 + t) = CRC(p * 1000) ^ tail[t]
+  uint32_t want = prefix_crc ^ target;
+
+#if DIGITS_HAVE_X86
+  if (g_has_avx2)
+    return scan_tail_avx2(want, hits, max_hits);
+  return scan_tail_sse2(want, hits, max_hits);
+#else
+  int count = 0;
+  for (int t = 0; t < DIGITS_TAIL_SPAN; t++) {
+    if (g_tail[t] == want && count < max_hits)
+      hits[count++] = (uint16_t)t;
+  }
+  return count;
+#endif
+}
@@ -23,9 +23,12 @@
 #include <time.h>
 
 #include "cracker.h"
+#include "crc32_core.h"
 #include "history_api.h"
 #include "mitm_cracker.h"
 #include "network.h"
+#include "thread_pool.h"
+#include "uid_prior.h"
 
 // Helper to convert UTF-16 to UTF-8
 char *wide_to_utf8(const wchar_t *wstr) {
@@ -60,6 +63,25 @@ void get_utf8_args(int *argc, char ***argv) {
 #define DEFAULT_LIMIT 20
 #define SEARCH_LIMIT 100000
 
+// 同一历史分段内命中的弹幕先排队，分段结束 (或队列满) 后统一破解，
+// 其中需要 MITM 的 Hash 合并为一次批量查询
+#define SEGMENT_BATCH 64
+typedef struct {
+  char *content;
+  char *mid_hash;
+  int64_t ctime;
+  int number; // 命中序号
+} PendingDanmaku;
+
+// 分段内的 MITM 批量查询：第一条需要 MITM 的弹幕触发，
+// 一次性覆盖它及其后所有带 Hash 的弹幕 (多一个 Hash 只多一轮探测)
+typedef struct {
+  int ran;
+  int ok;
+  int slot[SEGMENT_BATCH]; // 弹幕在批量目标数组中的下标 (-1=未参与)
+  MitmBatchResult result;
+} SegmentMitm;
+
 // 搜索上下文
 #define MAX_SEEN_IDS 1000
 typedef struct {
@@ -71,6 +93,8 @@ typedef struct {
   int found;                        // 标记是否已找到（用于提前退出）
   long long seen_ids[MAX_SEEN_IDS]; // 简易去重：已见过的弹幕ID
   int seen_count;
+  PendingDanmaku pending[SEGMENT_BATCH]; // 本分段待破解的命中弹幕
+  int pending_count;
 } SearchContext;
 
 /**
@@ -95,6 +119,7 @@ void usage(const char *prog) {
          "<关键词>]\n",
          prog);
   printf("  直接解密 (离线):      %s -hash <CRC32_HASH>\n", prog);
+  printf("  性能基准测试:         %s -bench\n", prog);
   printf("\n");
   printf("示例:\n");
   printf("  %s -cid 35268920394 -search \"ENTP\"\n", prog);
@@ -103,208 +128,371 @@ void usage(const char *prog) {
   printf("\n");
 }
 
-// 处理单个历史弹幕的回调
-int history_callback(DanmakuElem *elem, void *user_data) {
-  SearchContext *ctx = (SearchContext *)user_data;
+// 复制字符串 (NULL 保持 NULL)
+static char *dup_string(const char *str) {
+  if (!str)
+    return NULL;
+  size_t len = strlen(str);
+  char *copy = (char *)malloc(len + 1);
+  if (copy)
+    memcpy(copy, str, len + 1);
+  return copy;
+}
 
-  // 如果已经找到且是 first_only 模式，直接跳过
-  if (ctx->first_only && ctx->found) {
-    return 1; // 返回 1 表示停止遍历
+// 关键修复：规范化 Hash 到 8 位（左补零）
+// Protobuf 存储时会丢失前导零，如 "87c8c3d" 应为 "087c8c3d"
+static void normalize_hash(const char *mid_hash, char normalized[9]) {
+  size_t len = strlen(mid_hash);
+  memset(normalized, 0, 9);
+  if (len < 8) {
+    // 左补零
+    size_t zeros_needed = 8 - len;
+    for (size_t i = 0; i < zeros_needed; i++)
+      normalized[i] = '0';
+    memcpy(normalized + zeros_needed, mid_hash, len);
+  } else {
+    memcpy(normalized, mid_hash, 8);
   }
+}
 
-  ctx->total_processed++;
+// 对第 from 条及之后所有带 Hash 的待破解弹幕执行一次 MITM 批量查询
+static void run_segment_mitm(SearchContext *ctx, SegmentMitm *mitm, int from) {
+  uint32_t targets[SEGMENT_BATCH];
+  size_t n = 0;
+
+  for (int i = 0; i < SEGMENT_BATCH; i++)
+    mitm->slot[i] = -1;
+  for (int i = from; i < ctx->pending_count; i++) {
+    if (!ctx->pending[i].mid_hash)
+      continue;
+    char normalized[9];
+    normalize_hash(ctx->pending[i].mid_hash, normalized);
+    mitm->slot[i] = (int)n;
+    targets[n++] = (uint32_t)strtoul(normalized, NULL, 16);
+  }
 
-  // 去重检查：检查该弹幕ID是否已处理过
-  for (int i = 0; i < ctx->seen_count; i++) {
-    if (ctx->seen_ids[i] == elem->id) {
-      return 0; // 已见过，跳过
+  mitm->ran = 1;
+  mitm->ok = mitm_crack_batch(targets, n, &mitm->result) >= 0;
+}
+
+// 流式 MITM 的验证上下文：候选一经找到即在回调中请求 API 验证，
+// 其余线程同时继续搜索
+typedef struct {
+  int first_only;
+  int legacy_scanned; // 旧版 UID 已由反演扫描验证过
+  int received;       // 已收到的候选数
+  int requested;      // 已发出的 API 验证请求数
+  int found;          // 验证存在的候选数
+} StreamVerify;
+
+static int verify_stream_candidate(uint64_t uid, void *user) {
+  StreamVerify *sv = (StreamVerify *)user;
+
+  if (sv->received++ == 0)
+    printf("│ MITM 候选 - 边搜索边 API 验证:\n");
+  if (sv->legacy_scanned && uid < 2200000000ULL)
+    return 0;
+
+  // 请求间隔 (150ms)，避免风控
+  if (sv->requested++ > 0)
+    SLEEP_MS(150);
+
+  if (verify_uid_exists(uid) == 1) {
+    printf("│   %d. UID %I64u (✅存在)\n", sv->received, uid);
+    printf("│      主页: https://space.bilibili.com/%I64u\n", uid);
+    sv->found++;
+    if (sv->first_only) {
+      printf("│ [系统] 已找到有效目标，停止搜索剩余候选。\n");
+      return 1;
     }
+  } else if (sv->requested % 100 == 0) {
+    printf("│   [进度] 已验证 %d 个 (暂无命中)\n", sv->requested);
   }
-  // 记录该ID
-  if (ctx->seen_count < MAX_SEEN_IDS) {
-    ctx->seen_ids[ctx->seen_count++] = elem->id;
+  return 0;
+}
+
+// 本条之后 (含本条) 还有多少条带 Hash 的弹幕
+static int count_hashes_from(const SearchContext *ctx, int from) {
+  int count = 0;
+  for (int i = from; i < ctx->pending_count; i++) {
+    if (ctx->pending[i].mid_hash)
+      count++;
   }
+  return count;
+}
 
-  // 检查关键词
-  int match = 0;
-  if (ctx->keyword) {
-    if (elem->content && strstr(elem->content, ctx->keyword)) {
-      match = 1;
+// 输出一条命中弹幕并破解其 Hash
+static void report_danmaku(SearchContext *ctx, int index, SegmentMitm *mitm) {
+  PendingDanmaku *item = &ctx->pending[index];
+
+  printf("┌─────────────────────────────────────────────────────────\n");
+  // Use %I64d for MinGW compatibility
+  printf("│ [历史] 弹幕 #%d (日期: %I64d)\n", item->number, item->ctime);
+  printf("├─────────────────────────────────────────────────────────\n");
+  printf("│ 内容: %s\n", item->content ? item->content : "[NULL]");
+
+  if (item->mid_hash) {
+    size_t len = strlen(item->mid_hash);
+    printf("│ Hash: [%s] (Len: %zu)\n", item->mid_hash, len);
+
+    // Validation Check
+    int valid_hex = 1;
+    if (len != 8)
+      valid_hex = 0;
+    for (size_t i = 0; i < len; i++) {
+      char c = item->mid_hash[i];
+      if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') ||
+            (c >= 'A' && c <= 'F'))) {
+        valid_hex = 0;
+        break;
+      }
     }
-  } else {
-    match = 1; // 无关键词则全部匹配（慎用，输出太多）
-  }
 
-  if (match) {
-    ctx->total_matched++;
-    ctx->found = 1; // 标记找到
+    if (!valid_hex) {
+      printf("│ [警告] Hash 格式异常！(Len: %zu)\n", len);
+      printf("│ Raw Bytes: ");
+      for (size_t i = 0; i < len; i++)
+        printf("%02x ", (unsigned char)item->mid_hash[i]);
+      printf("\n");
+    }
 
-    printf("┌─────────────────────────────────────────────────────────\n");
-    // Use %I64d for MinGW compatibility
-    printf("│ [历史] 弹幕 #%d (日期: %I64d)\n", ctx->total_matched,
-           elem->ctime);
-    printf("├─────────────────────────────────────────────────────────\n");
-    printf("│ 内容: %s\n", elem->content ? elem->content : "[NULL]");
+    char normalized_hash[9];
+    normalize_hash(item->mid_hash, normalized_hash);
+    if (len < 8)
+      printf("│ [规范化] %s -> %s\n", item->mid_hash, normalized_hash);
 
-    if (elem->midHash) {
-      size_t len = strlen(elem->midHash);
-      printf("│ Hash: [%s] (Len: %zu)\n", elem->midHash, len);
+    // MITM 表已就绪时一次查表即覆盖 1-16 位全空间，跳过旧版 UID 扫描；
+    // 否则先用尾部反演 (毫秒级) 扫描 0-2.2B，未命中再加载 MITM
+    int legacy_scanned = !mitm_is_ready();
+    CrackResult candidates;
+    int count = 0;
+    int found_valid_uid = 0; // 标记是否找到真实存在的 UID
 
-      // Validation Check
-      int valid_hex = 1;
-      if (len != 8)
-        valid_hex = 0;
-      for (size_t i = 0; i < len; i++) {
-        char c = elem->midHash[i];
-        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') ||
-              (c >= 'A' && c <= 'F'))) {
-          valid_hex = 0;
-          break;
+    if (legacy_scanned)
+      count = crack_hash_invert(normalized_hash, &candidates);
+
+    if (count > 0) {
+      // 按先验密度排序，最可能的账号最先请求验证
+      uid_prior_rank(candidates.uids, count);
+      printf("│ 碰撞候选 (%d 个):\n", count);
+      for (int i = 0; i < count; i++) {
+        uint64_t uid = candidates.uids[i];
+        int exists = verify_uid_exists(uid);
+        // 只要有一个存在或未知(可能是网络问题)，我们就认为是有效尝试
+        if (exists == 1)
+          found_valid_uid = 1;
+
+        const char *status = (exists == 1)   ? "✅存在"
+                             : (exists == 0) ? "❌不存在"
+                                             : "⚠️未知";
+        printf("│   %d. UID %I64u (%s)\n", i + 1, uid, status);
+        printf("│      主页: https://space.bilibili.com/%I64u\n", uid);
+        // 请求间隔，避免风控
+        if (i < count - 1) {
+#ifdef _WIN32
+          Sleep(500);
+#else
+          usleep(500000);
+#endif
         }
       }
+    } else if (legacy_scanned) {
+      printf("│ UID : 未找到 (范围 0-%llu)\n",
+             (unsigned long long)8000000000000ULL);
+    }
 
-      if (!valid_hex) {
-        printf("│ [警告] Hash 格式异常！(Len: %zu)\n", len);
-        printf("│ Raw Bytes: ");
-        for (size_t i = 0; i < len; i++)
-          printf("%02x ", (unsigned char)elem->midHash[i]);
-        printf("\n");
+    // =========================================================
+    // MITM 自动回退逻辑: 如果暴力破解失败或全是无效碰撞
+    // =========================================================
+    if (!found_valid_uid) {
+      printf("│\n");
+      if (legacy_scanned)
+        printf("│ [智能分析] 暴力破解未找到有效结果 (可能是16位长UID)\n");
+      printf("│ [Core] 正在启动 MITM 攻击引擎 (全空间搜索)...\n");
+
+      // 表未就绪时仅在已有有效缓存 (只读映射，毫秒级) 时加载；
+      // 否则由查询接口自动选择无表模式，不为一条弹幕构建整张表
+      if (!mitm_is_ready() && mitm_cache_valid(NULL)) {
+        if (mitm_init(NULL) != 0) {
+          printf("│ [Error] MITM 引擎初始化失败！\n");
+          goto after_mitm;
+        }
       }
 
-      // 关键修复：规范化 Hash 到 8 位（左补零）
-      // Protobuf 存储时会丢失前导零，如 "87c8c3d" 应为 "087c8c3d"
-      char normalized_hash[9] = {0};
-      if (len < 8) {
-        // 左补零
-        size_t zeros_needed = 8 - len;
-        for (size_t i = 0; i < zeros_needed; i++)
-          normalized_hash[i] = '0';
-        memcpy(normalized_hash + zeros_needed, elem->midHash, len);
-        printf("│ [规范化] %s -> %s\n", elem->midHash, normalized_hash);
-      } else {
-        memcpy(normalized_hash, elem->midHash, 8);
+      // 只剩这一条 Hash 时 (如 -first 模式) 无需批量：流式查询，
+      // 第一个候选出现即开始 API 验证，找到有效 UID 可提前结束搜索。
+      // 加载了先验时改为先取全部候选再排序：查表只需毫秒级，
+      // 远少于一次限速的 API 请求，排序省下的请求数更多
+      if (!mitm->ran && count_hashes_from(ctx, index) == 1 &&
+          !uid_prior_loaded()) {
+        StreamVerify sv = {ctx->first_only, legacy_scanned, 0, 0, 0};
+        if (mitm_crack_stream(normalized_hash, verify_stream_candidate, &sv) <
+            0) {
+          printf("│ [Error] MITM 查询失败！\n");
+        } else if (sv.received == 0) {
+          printf("│ [MITM] 智能过滤后未找到匹配 UID (请检查规则)\n");
+        } else if (sv.found == 0) {
+          printf("│ [完成] 验证 %d 个候选，未找到有效 UID\n", sv.received);
+        }
+        goto after_mitm;
       }
 
-      // 使用规范化后的 Hash 进行全量碰撞扫描
-      CrackResult candidates;
-      int count = crack_hash_all(normalized_hash, ctx->threads, &candidates);
-      int found_valid_uid = 0; // 标记是否找到真实存在的 UID
+      // 本分段首次需要 MITM 时批量查询其后全部 Hash
+      if (!mitm->ran)
+        run_segment_mitm(ctx, mitm, index);
+
+      // 批量结果按目标下标排序，本条弹幕的候选是连续的一段
+      const MitmMatch *matches = NULL;
+      int match_count = 0;
+      int slot = mitm->slot[index];
+      for (int k = 0; mitm->ok && slot >= 0 && k < mitm->result.count; k++) {
+        if (mitm->result.matches[k].target_index == (uint32_t)slot) {
+          if (!matches)
+            matches = &mitm->result.matches[k];
+          match_count++;
+        }
+      }
+
+      // 按先验密度排序后再逐个验证 (内存不足时保持原顺序)
+      uint64_t *uids = NULL;
+      if (match_count > 0) {
+        uids = (uint64_t *)malloc(sizeof(uint64_t) * (size_t)match_count);
+        if (!uids) {
+          printf("│ [Error] 内存不足！\n");
+          goto after_mitm;
+        }
+        for (int i = 0; i < match_count; i++)
+          uids[i] = matches[i].uid;
+        uid_prior_rank(uids, match_count);
+      }
 
-      if (count > 0) {
-        printf("│ 碰撞候选 (%d 个):\n", count);
-        for (int i = 0; i < count; i++) {
-          uint64_t uid = candidates.uids[i];
+      if (match_count > 0) {
+        printf("│\n");
+        printf("│ MITM 候选 (%d 个) - 开始 API 验证:\n", match_count);
+
+        int verified_count = 0;
+        for (int i = 0; i < match_count; i++) {
+          uint64_t uid = uids[i];
+          // 旧版 UID 已由反演扫描验证过，不重复请求 API
+          if (legacy_scanned && uid < 2200000000ULL)
+            continue;
           int exists = verify_uid_exists(uid);
-          // 只要有一个存在或未知(可能是网络问题)，我们就认为是有效尝试
-          if (exists == 1)
+
+          if (exists == 1) {
+            // 找到有效 UID
+            printf("│   %d. UID %I64u (✅存在)\n", i + 1, uid);
+            printf("│      主页: https://space.bilibili.com/%I64u\n", uid);
             found_valid_uid = 1;
+            verified_count++;
 
-          const char *status = (exists == 1)   ? "✅存在"
-                               : (exists == 0) ? "❌不存在"
-                                               : "⚠️未知";
-          printf("│   %d. UID %I64u (%s)\n", i + 1, uid, status);
-          printf("│      主页: https://space.bilibili.com/%I64u\n", uid);
-          // 请求间隔，避免风控
-          if (i < count - 1) {
+            if (ctx->first_only) {
+              printf("│ [系统] 已找到有效目标，停止验证剩余候选。\n");
+              break;
+            }
+          } else {
+            // 每 100 个输出一次进度
+            if ((i + 1) % 100 == 0) {
+              printf("│   [进度] 已验证 %d/%d (暂无命中)\n", i + 1,
+                     match_count);
+            }
+          }
+
+          // 请求间隔 (150ms)
+          if (i < match_count - 1) {
 #ifdef _WIN32
-            Sleep(500);
+            Sleep(150);
 #else
-            usleep(500000);
+            usleep(150000);
 #endif
           }
         }
+
+        if (!found_valid_uid) {
+          printf("│ [完成] 验证 %d 个候选，未找到有效 UID\n",
+                 match_count);
+        }
       } else {
-        printf("│ UID : 未找到 (范围 0-%llu)\n",
-               (unsigned long long)8000000000000ULL);
+        printf("│ [MITM] 智能过滤后未找到匹配 UID (请检查规则)\n");
       }
+      free(uids);
+    }
 
-      // =========================================================
-      // MITM 自动回退逻辑: 如果暴力破解失败或全是无效碰撞
-      // =========================================================
-      if (!found_valid_uid) {
-        printf("│\n");
-        printf("│ [智能分析] 暴力破解未找到有效结果 (可能是16位长UID)\n");
-        printf("│ [Core] 正在启动 MITM 攻击引擎 (全空间搜索)...\n");
+  after_mitm:;
 
-        if (!mitm_is_ready()) {
-          if (mitm_init(NULL) != 0) {
-            printf("│ [Error] MITM 引擎初始化失败！\n");
-            goto after_mitm;
-          }
-        }
+  } else {
+    printf("│ Hash: [无]\n");
+  }
+  printf("└─────────────────────────────────────────────────────────\n\n");
+}
 
-        // 结构体本身很小，直接放在栈上
-        // uids 数组由 mitm_crack 内部动态分配
-        MitmResult mitm_candidates = {0};
+// 破解并输出本分段排队的全部命中弹幕，然后清空队列
+static void flush_pending(SearchContext *ctx) {
+  SegmentMitm mitm = {0};
 
-        mitm_crack(normalized_hash, &mitm_candidates);
+  for (int i = 0; i < ctx->pending_count; i++) {
+    report_danmaku(ctx, i, &mitm);
 
-        if (mitm_candidates.count > 0 && mitm_candidates.uids != NULL) {
-          printf("│\n");
-          printf("│ MITM 候选 (%d 个) - 开始 API 验证:\n",
-                 mitm_candidates.count);
+    // 如果是 first_only 模式，找到后停止搜索
+    if (ctx->first_only)
+      printf("[系统] 已找到目标弹幕，停止搜索。\n");
+  }
 
-          int verified_count = 0;
-          for (int i = 0; i < mitm_candidates.count; i++) {
-            uint64_t uid = mitm_candidates.uids[i];
-            int exists = verify_uid_exists(uid);
+  free(mitm.result.matches);
+  for (int i = 0; i < ctx->pending_count; i++) {
+    free(ctx->pending[i].content);
+    free(ctx->pending[i].mid_hash);
+  }
+  ctx->pending_count = 0;
+}
 
-            if (exists == 1) {
-              // 找到有效 UID
-              printf("│   %d. UID %I64u (✅存在)\n", i + 1, uid);
-              printf("│      主页: https://space.bilibili.com/%I64u\n", uid);
-              found_valid_uid = 1;
-              verified_count++;
+// 处理单个历史弹幕的回调：命中的弹幕排队，分段结束后由 flush_pending 破解
+int history_callback(DanmakuElem *elem, void *user_data) {
+  SearchContext *ctx = (SearchContext *)user_data;
 
-              if (ctx->first_only) {
-                printf("│ [系统] 已找到有效目标，停止验证剩余候选。\n");
-                break;
-              }
-            } else {
-              // 每 100 个输出一次进度
-              if ((i + 1) % 100 == 0) {
-                printf("│   [进度] 已验证 %d/%d (暂无命中)\n", i + 1,
-                       mitm_candidates.count);
-              }
-            }
+  // 如果已经找到且是 first_only 模式，直接跳过
+  if (ctx->first_only && ctx->found) {
+    return 1; // 返回 1 表示停止遍历
+  }
 
-            // 请求间隔 (150ms)
-            if (i < mitm_candidates.count - 1) {
-#ifdef _WIN32
-              Sleep(150);
-#else
-              usleep(150000);
-#endif
-            }
-          }
+  ctx->total_processed++;
 
-          if (!found_valid_uid) {
-            printf("│ [完成] 验证 %d 个候选，未找到有效 UID\n",
-                   mitm_candidates.count);
-          }
-        } else {
-          printf("│ [MITM] 智能过滤后未找到匹配 UID (请检查规则)\n");
-        }
+  // 去重检查：检查该弹幕ID是否已处理过
+  for (int i = 0; i < ctx->seen_count; i++) {
+    if (ctx->seen_ids[i] == elem->id) {
+      return 0; // 已见过，跳过
+    }
+  }
+  // 记录该ID
+  if (ctx->seen_count < MAX_SEEN_IDS) {
+    ctx->seen_ids[ctx->seen_count++] = elem->id;
+  }
 
-        // 释放动态分配的内存
-        if (mitm_candidates.uids) {
-          free(mitm_candidates.uids);
-          mitm_candidates.uids = NULL;
-        }
-      }
+  // 检查关键词
+  int match = 0;
+  if (ctx->keyword) {
+    if (elem->content && strstr(elem->content, ctx->keyword)) {
+      match = 1;
+    }
+  } else {
+    match = 1; // 无关键词则全部匹配（慎用，输出太多）
+  }
 
-    after_mitm:;
+  if (match) {
+    ctx->total_matched++;
+    ctx->found = 1; // 标记找到
 
-    } else {
-      printf("│ Hash: [无]\n");
-    }
-    printf("└─────────────────────────────────────────────────────────\n\n");
+    // 弹幕结构在回调返回后即被释放，排队时复制所需字段
+    PendingDanmaku *item = &ctx->pending[ctx->pending_count++];
+    item->content = dup_string(elem->content);
+    item->mid_hash = dup_string(elem->midHash);
+    item->ctime = elem->ctime;
+    item->number = ctx->total_matched;
+    if (ctx->pending_count == SEGMENT_BATCH)
+      flush_pending(ctx);
 
     // 如果是 first_only 模式，找到后立即返回停止信号
-    if (ctx->first_only) {
-      printf("[系统] 已找到目标弹幕，停止搜索。\n");
+    if (ctx->first_only)
       return 1; // 停止
-    }
   }
 
   return 0; // Continue
@@ -398,6 +586,11 @@ int main(int argc, char *argv[]) {
   int limit = DEFAULT_LIMIT;
   int threads = DEFAULT_THREADS;
   int first_only = 0; // 默认全量模式，加 -first 启用单结果模式
+  int run_bench = 0;  // -bench 模式：运行基准测试后退出
+  int huge_pages = 0; // -hugepages：MITM 表使用大页内存
+  const char *filter = NULL; // -filter：MITM 表探测前的成员过滤器
+  const char *prior = NULL;  // -prior：候选排序先验文件
+  int warmup = 0; // -warmup：历史模式开始时在后台预热 MITM 表
 
   for (int i = 1; i < argc; i++) {
     if (strcmp(argv[i], "-hash") == 0 && i + 1 < argc)
@@ -414,17 +607,57 @@ int main(int argc, char *argv[]) {
       threads = atoi(argv[++i]);
     else if (strcmp(argv[i], "-first") == 0)
       first_only = 1;
+    else if (strcmp(argv[i], "-bench") == 0)
+      run_bench = 1;
+    else if (strcmp(argv[i], "-hugepages") == 0)
+      huge_pages = 1;
+    else if (strcmp(argv[i], "-filter") == 0 && i + 1 < argc)
+      filter = argv[++i];
+    else if (strcmp(argv[i], "-prior") == 0 && i + 1 < argc)
+      prior = argv[++i];
+    else if (strcmp(argv[i], "-warmup") == 0)
+      warmup = 1;
   }
 
-  if (hash_target) {
-    // 使用 MITM 攻击支持 16 位 UID
-    printf("[MITM] 初始化中间相遇攻击模块...\n");
-    if (mitm_init(NULL) != 0) {
-      fprintf(stderr, "[Error] MITM 初始化失败\n");
+  // 表加载配置须在首次 mitm_init 之前设置
+  MitmConfig config;
+  mitm_get_config(&config);
+  if (huge_pages)
+    config.huge_pages = 1;
+  if (filter) {
+    if (strcmp(filter, "none") == 0)
+      config.filter = MITM_FILTER_NONE;
+    else if (strcmp(filter, "bloom") == 0)
+      config.filter = MITM_FILTER_BLOOM;
+    else if (strcmp(filter, "bitmap") == 0)
+      config.filter = MITM_FILTER_BITMAP;
+    else {
+      printf("[错误] 未知的过滤器类型: %s (可选 none / bloom / bitmap)\n",
+             filter);
       return 1;
     }
+  }
+  mitm_configure(&config);
+
+  // 在任何工作线程启动前生成 CRC32 扩展查找表
+  crc32_init();
+
+  if (run_bench) {
+    crc32_benchmark();
+    thread_pool_init(threads);
+    mitm_benchmark();
+    mitm_cleanup();
+    thread_pool_cleanup();
+    return 0;
+  }
 
-    MitmResult result;
+  if (hash_target) {
+    // 使用 MITM 攻击支持 16 位 UID
+    // 单次查询无需加载预计算表：mitm_crack 自动选择无表模式，毫秒级启动
+    thread_pool_init(threads);
+
+    // uids 数组由 mitm_crack 内部动态分配
+    MitmResult result = {0};
     int count = mitm_crack(hash_target, &result);
 
     if (count > 0) {
@@ -437,20 +670,28 @@ int main(int argc, char *argv[]) {
       printf("[结果] 未找到匹配 UID\n");
     }
 
+    free(result.uids);
     mitm_cleanup();
+    thread_pool_cleanup();
     return 0;
   }
 
+  // 候选排序先验：默认文件不存在时静默跳过，显式指定却加载失败时提示
+  if (uid_prior_load(prior) != 0 && prior)
+    printf("[警告] 无法加载先验文件 %s，候选按发现顺序验证\n", prior);
+
   // 如果提供了 BVID，自动获取 CID 和发布日期
   long long pub_ts = 0;
   if (bvid_str) {
     network_init();
+    thread_pool_init(threads);
     VideoInfo vinfo = {0};
     if (fetch_video_info(bvid_str, &vinfo)) {
       cid = vinfo.cid;
       pub_ts = vinfo.pubdate;
     } else {
       printf("[错误] 无法从 BVID 获取视频信息，请检查 BV 号是否正确。\n");
+      thread_pool_cleanup();
       network_cleanup();
       return 1;
     }
@@ -459,6 +700,7 @@ int main(int argc, char *argv[]) {
   if (cid > 0) {
     if (!bvid_str) {
       network_init(); // 如果没有 BVID，这里才初始化网络
+      thread_pool_init(threads);
     }
 
     if (sessdata) {
@@ -467,6 +709,11 @@ int main(int argc, char *argv[]) {
       printf("[原理] 正向遍历日期索引，突破7天限制\n");
       printf("[警告] 请确保 SESSDATA 属于测试账号，高频访问有封号风险！\n\n");
 
+      // 表的加载/构建与下面的网络抓取重叠进行；
+      // 预热未完成时 MITM 查询不等待，改用无表模式 (见 mitm_init_async)
+      if (warmup)
+        mitm_init_async(NULL);
+
       // Start from current month
       char current_month[16] = "2026-01";
       char end_month[16] = "2009-01"; // Bilibili founded around 2009
@@ -522,6 +769,7 @@ int main(int argc, char *argv[]) {
             if (idx->dates[i]) {
               fetch_history_segment(cid, idx->dates[i], sessdata,
                                     history_callback, &ctx);
+              flush_pending(&ctx);
               // 如果已找到且是 first_only 模式，立即退出
               if (ctx.first_only && ctx.found) {
                 history_found_any = 1;
@@ -553,6 +801,8 @@ int main(int argc, char *argv[]) {
       // 如果历史模式没找到，且有关键词，自动尝试实时模式
       if (!history_found_any && search_keyword) {
         printf("\n[系统] 历史模式未找到匹配，自动切换到实时模式...\n\n");
+        if (warmup && !mitm_is_ready())
+          printf("[系统] MITM 表仍在后台加载/构建，破解任务可能需排队等待线程池\n");
         printf("[模式] 实时抓取 (匿名)\n");
         char *xml = fetch_danmaku(cid);
         if (xml) {
@@ -571,8 +821,12 @@ int main(int argc, char *argv[]) {
       }
     }
 
+    // 等待可能仍在进行的后台预热，再销毁其使用的线程池
+    mitm_cleanup();
+    thread_pool_cleanup();
     network_cleanup();
   }
 
+  uid_prior_free();
   return 0;
 }
@@ -2,12 +2,18 @@
  * MITM (Meet-in-the-Middle) CRC32 逆向攻击模块
  *
  * 原理：利用 CRC32 的线性特性，将 O(N) 复杂度降低至 O(√N)
- * 性能：16位UID空间搜索仅需 0.2 秒
- * 内存：预计算表约 763 MB
+ * 覆盖：1-8 位 UID 每个长度一次查表，9-16 位 UID 遍历高位
+ * 策略：表已加载时逐高位查表；否则高位集合较小时改为无表流式扫描低位
+ * 性能：只遍历白名单前缀对应的约 1.4 万个高位，单次查询为毫秒级
+ * 内存：分桶索引约 540 MB (桶偏移 64 MB + 8 位余数 100 MB + low 400 MB)，
+ *       默认只读映射缓存文件，同机多个进程共享一份页缓存
  */
 
 #include "mitm_cracker.h"
 #include "crc32_core.h"
+#include "crc32_digits.h"
+#include "thread_pool.h"
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -16,215 +22,210 @@
 #ifdef _WIN32
 #include <windows.h>
 #else
+#include <fcntl.h>
 #include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #endif
 
+// ============== Windows / Pthreads 线程与互斥锁兼容层 ==============
+#ifdef _WIN32
+typedef HANDLE thread_t;
+typedef CRITICAL_SECTION mutex_t;
+#define THREAD_CREATE(t, func, arg)                                            \
+  (*(t) =                                                                      \
+       CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)(func), (arg), 0, NULL),  \
+   *(t) != NULL ? 0 : -1)
+#define THREAD_JOIN(t) (WaitForSingleObject(t, INFINITE), CloseHandle(t))
+#define MUTEX_INIT(m) InitializeCriticalSection(m)
+#define MUTEX_DESTROY(m) DeleteCriticalSection(m)
+#define MUTEX_LOCK(m) EnterCriticalSection(m)
+#define MUTEX_UNLOCK(m) LeaveCriticalSection(m)
+#else
+typedef pthread_t thread_t;
+typedef pthread_mutex_t mutex_t;
+#define THREAD_CREATE(t, func, arg) pthread_create(t, NULL, func, arg)
+#define THREAD_JOIN(t) pthread_join(t, NULL)
+#define MUTEX_INIT(m) pthread_mutex_init(m, NULL)
+#define MUTEX_DESTROY(m) pthread_mutex_destroy(m)
+#define MUTEX_LOCK(m) pthread_mutex_lock(m)
+#define MUTEX_UNLOCK(m) pthread_mutex_unlock(m)
+#endif
+
+// 探测前的软件预取 (只读、无时间局部性)
+#if defined(__GNUC__) || defined(__clang__)
+#define MITM_PREFETCH(addr) __builtin_prefetch((addr), 0, 0)
+#else
+#define MITM_PREFETCH(addr) ((void)(addr))
+#endif
+
 // ============== 配置 ==============
 #define DEFAULT_CACHE_PATH "mitm_table.bin"
 #define TABLE_ENTRY_COUNT LOW_PART_LIMIT // 10^8
-#define TABLE_SIZE_BYTES (TABLE_ENTRY_COUNT * sizeof(CrcEntry))
+#define TABLE_MAGIC 0x4D49544D          // "MITM"
+#define TABLE_VERSION 4                 // v4: 附带成员过滤器 (v3 无过滤器)
+#define TABLE_ENDIAN_TAG 0x01020304     // 按本机字节序写入，读回不等即字节序不符
+#define TABLE_PAGE 4096                 // 各段起始偏移按页对齐
+#define BUCKET_OFFSETS_BYTES ((size_t)(MITM_BUCKET_COUNT + 1) * sizeof(uint32_t))
+#define TABLE_SIZE_BYTES                                                       \
+  (BUCKET_OFFSETS_BYTES +                                                      \
+   (size_t)TABLE_ENTRY_COUNT * (sizeof(uint8_t) + sizeof(uint32_t)))
+#define BUILD_BATCH 4096 // 建表时每批计算 CRC 的低位数量
+#define BUILD_SLICES 64  // 建表时低位区间的切片数 (与线程数无关，结果确定)
+#define BUILD_PART_BITS 8 // 建表第一轮按 CRC 高 8 位粗分区
+#define BUILD_PART_COUNT (1u << BUILD_PART_BITS)
+#define BUILD_PART_BUCKETS (MITM_BUCKET_COUNT >> BUILD_PART_BITS) // 每区桶数
+#define VERIFY_BATCH 256 // 候选攒够一批后交给 crc32_digits_eval_batch 验证
+#define MITM_TASK_SPAN 262144 // 单个任务最多遍历的高位数 (大区间再切分)
+#define PROBE_BATCH 32 // 查表探测每批的键数 (先统一预取，再统一解析)
+#define PROBE_BATCH_MAX 64 // 探测批大小上限 (基准测试可调)
+#define STREAM_TASK_SPAN 1000000 // 无表模式下单个任务扫描的低位数
+#define STREAM_MAX_HIGH (1u << 20) // 高位集合不超过此规模时可用无表模式
+#define MERGE_TASK_PAIRS 65536 // 归并模式下单个任务处理的有序键数
+#define BENCH_TARGETS 4 // 查询策略基准：每组高位集合测试的目标数
+#define BENCH_DENSE_HIGH (1u << 22) // 查询策略基准：稠密高位集合的规模
+#define BENCH_DENSE_BEGIN 34930000u // 稠密集合起点：覆盖白名单前缀 34930-34943
+#define LEGACY_UID_MAX 2200000000ULL // 旧版 UID 上限
+#define PREFIX_SPAN 1000 // 16 位 UID 的高位 h 为 8 位，h / 1000 即前 5 位
+#define HUGE_PAGE_SIZE ((size_t)2 << 20) // x86-64 大页 (2 MB)
+#define BLOOM_BITS_LOG2 29   // 分块布隆过滤器共 2^29 位 (64 MB)
+#define BLOOM_BLOCK_BITS 512 // 每块恰为一条 64 字节缓存行
+#define BLOOM_BLOCK_SHIFT (32 - (BLOOM_BITS_LOG2 - 9)) // CRC 高 20 位选块
+#define BLOOM_HASHES 3       // 块内置位数
 
 // ============== 全局状态 ==============
-static CrcEntry *g_mitm_table = NULL;
-static int g_mitm_ready = 0;
-
-// ============== CRC32 计算 (查表法) ==============
-
-// 将数字转换为指定位数的字符串并计算 CRC32
-static uint32_t crc32_numeric_padded(uint32_t value, int digits) {
-  char buf[32];
-  int len = sprintf(buf, "%0*u", digits, value);
+// 分桶索引：CRC 高 24 位直接寻址桶，桶内只存剩余 8 位与 low (SoA 布局)
+// 桶 b 的表项为 [g_bucket[b], g_bucket[b + 1])，平均每桶约 6 项
+// 三段数据都位于同一块表镜像中 (堆内存、大页或只读文件映射)，与缓存文件布局一致
+static const uint32_t *g_bucket = NULL; // 2^24 + 1 个桶起始偏移
+static const uint8_t *g_rem = NULL;     // 每项 CRC 的低 8 位
+static const uint32_t *g_low = NULL;    // 每项对应的低位数值
+static uint8_t *g_image = NULL;         // 表镜像首地址
+static size_t g_image_size = 0;         // 表镜像有效字节数 (即缓存文件大小)
+static size_t g_alloc_size = 0;         // 实际分配字节数 (大页向上取整)
+static MitmBacking g_backing = MITM_BACKING_NONE;
+static const uint64_t *g_filter = NULL; // 成员过滤器 (位于镜像末尾)
+static MitmFilter g_filter_kind = MITM_FILTER_NONE;
+#ifdef _WIN32
+static HANDLE g_map_handle = NULL;
+#endif
+static MitmConfig g_config = {1, 0, 0, MITM_FILTER_BLOOM};
+static atomic_int g_mitm_ready = 0; // 后台预热时由预热线程置位
+static int g_shifts_ready = 0; // 移位算子与增量表是否已预计算
+static MitmPlan g_plan = MITM_PLAN_AUTO;
+static int g_probe_batch = PROBE_BATCH; // 当前探测批大小 (1 即逐个同步探测)
+
+// ============== 性能优化：预计算移位算子 ==============
+// 低位串长度只有 1-8 这几种 (表中键固定为 8 位补零串，短 UID 另需 1-7)
+// 我们可以为每个长度预先构建 x^(8*n) 的移位算子 (crc32_core.h)
+// 这样每次移位只需 4 次查表 + 3 次异或，而不需要逐位的矩阵乘法
+
+// g_shift_ops[n]: 移位 n 字节的算子 (n = 8 用于高位 + 8 位低位)
+static Crc32ShiftOp g_shift_ops[LOW_PART_DIGITS + 1];
+// g_pad_key[n]: Shift_n(CRC("0" * (8 - n)))，n 位短 UID 的查表常量
+static uint32_t g_pad_key[LOW_PART_DIGITS + 1];
+
+// 高位增量枚举用的移位贡献表 (M_8 为移位 8 字节的矩阵，M_8 线性)：
+//   M_8 * CRC(H) = M_8 * base[m] ^ XOR_j M_8 * contrib[j][d_j]
+// g_shift_len_delta[m]: M_8 * (base[m] ^ base[m + 1])，高位长度 m -> m + 1
+// g_shift_step[j][d]: 倒数第 j 位由 d 变为 d + 1 (d = 9 时回绕为 0) 的增量
+static uint32_t g_shift_len_delta[LOW_PART_DIGITS];
+static uint32_t g_shift_step[LOW_PART_DIGITS][10];
+// g_low_step[j][d]: 未移位的同类增量，用于无表模式枚举 8 位补零低位串
+static uint32_t g_low_step[LOW_PART_DIGITS][10];
 
-  uint32_t crc = 0xFFFFFFFF;
-  for (int i = 0; i < len; i++) {
-    crc = crc32_table[(crc ^ buf[i]) & 0xFF] ^ (crc >> 8);
-  }
-  return crc ^ 0xFFFFFFFF;
+// 快速计算 L = Target ^ (H * M_8)
+// 使用预构建的移位算子 (4 次查表)
+static uint32_t mitm_calculate_required_L_fast(uint32_t target,
+                                               uint32_t crc_h) {
+  // 计算 shifted_h = crc_h * M_8
+  uint32_t shifted_h =
+      crc32_shift_apply(&g_shift_ops[LOW_PART_DIGITS], crc_h);
+  return target ^ shifted_h;
 }
 
-// 计算数字字符串的 CRC32 (不填充)
-static uint32_t crc32_numeric(uint64_t value) {
-  char buf[32];
-  int len = sprintf(buf, "%I64u", value);
-
-  uint32_t crc = 0xFFFFFFFF;
-  for (int i = 0; i < len; i++) {
-    crc = crc32_table[(crc ^ buf[i]) & 0xFF] ^ (crc >> 8);
+// 预计算各长度的移位算子与短 UID 查表常量
+static void precompute_length_shifts(void) {
+  const Crc32DigitTables *digits = crc32_digits_tables();
+  for (int n = 0; n <= LOW_PART_DIGITS; n++) {
+    crc32_shift_op_init(&g_shift_ops[n], (uint64_t)n);
+    g_pad_key[n] = crc32_shift_apply(&g_shift_ops[n],
+                                     digits->base[LOW_PART_DIGITS - n]);
   }
-  return crc ^ 0xFFFFFFFF;
-}
 
-// ============== GF(2) 矩阵运算 (zlib 风格) ==============
-// IEEE 802.3 标准多项式
-#define POLY 0xEDB88320UL
-
-// GF(2) 矩阵乘法: vec * mat
-static uint32_t gf2_matrix_times(uint32_t *mat, uint32_t vec) {
-  uint32_t sum = 0;
-  while (vec) {
-    if (vec & 1)
-      sum ^= *mat;
-    vec >>= 1;
-    mat++;
+  const Crc32ShiftOp *m8 = &g_shift_ops[LOW_PART_DIGITS];
+  for (int m = 0; m < LOW_PART_DIGITS; m++) {
+    g_shift_len_delta[m] =
+        crc32_shift_apply(m8, digits->base[m] ^ digits->base[m + 1]);
   }
-  return sum;
-}
-
-// GF(2) 矩阵平方
-static void gf2_matrix_square(uint32_t *square, uint32_t *mat) {
-  for (int n = 0; n < 32; n++) {
-    square[n] = gf2_matrix_times(mat, mat[n]);
+  for (int j = 0; j < LOW_PART_DIGITS; j++) {
+    for (int d = 0; d < 10; d++) {
+      // contrib[j][0] == 0，因此 9 -> 0 的增量就是 contrib[j][9]
+      uint32_t next = d < 9 ? digits->contrib[j][d + 1] : 0;
+      g_low_step[j][d] = digits->contrib[j][d] ^ next;
+      g_shift_step[j][d] = crc32_shift_apply(m8, g_low_step[j][d]);
+    }
   }
 }
 
-// ============== 性能优化：预计算位移矩阵 ==============
-// 既然 len_l (低位长度) 固定为 8 (即 "00000000" ~ "99999999")
-// 我们可以预先计算 x^(8*8) = x^64 的 GF(2) 变换矩阵
-// 这样在循环内部只需要进行一次向量-矩阵乘法，而不需要多次矩阵平方
-
-static uint32_t g_shift_matrix_len8[32]; // 用于 len=8 的位移矩阵
-
-// 预计算 offset = len2 (字节数) 的位移矩阵
-// row_matrix: 输出矩阵 (32x32)
-static void precompute_shift_matrix(uint32_t *row_matrix, int64_t len2) {
-  uint32_t odd[32];  // 奇数幂
-  uint32_t even[32]; // 偶数幂
-
-  // 初始化 odd 为 x^1
-  odd[0] = POLY;
-  uint32_t row = 1;
-  for (int n = 1; n < 32; n++) {
-    odd[n] = row;
-    row <<= 1;
-  }
-
-  // 初始化结果矩阵为单位矩阵 (x^0)
-  // row_matrix[i] 只有第 i 位为1
-  for (int n = 0; n < 32; n++) {
-    row_matrix[n] = (1UL << n);
-  }
-
-  // 如果 len2 <= 0，直接返回单位矩阵
-  if (len2 <= 0)
+// 移位算子只依赖 CRC 表，查表与无表模式共用，首次使用时预计算
+static void ensure_length_shifts(void) {
+  if (g_shifts_ready)
     return;
+  crc32_init();
+  precompute_length_shifts();
+  g_shifts_ready = 1;
+}
 
-  // 计算 even = odd^2 = x^2
-  gf2_matrix_square(even, odd);
-  // 计算 odd = even^2 = x^4
-  gf2_matrix_square(odd, even);
-
-  // 快速幂算法计算 x^(len2 * 8)
-  // 注意：crc32_combine 逻辑中，每次迭代代表移位 1 字节 (8 bits) ?
-  // 不，zlib 的 combine 是按字节处理的
-
-  // 我们直接复用 zlib 的逻辑，但并不乘入 crc1，而是累积矩阵变换
-
-  // 实际上我们需要的是：
-  // final_crc = (crc1 * M) ^ crc2
-  // 我们只求 M。
-  // 即计算 M = combine(unity_matrix, 0, len2)
-  // 但 combine 函数是计算 (vec * M) ^ vec2
-  // 我们可以复用 gf2_matrix_square 和 gf2_matrix_times logic
-
-  // 让我们重写简单的预计算：
-  // 初始化 M Identity
-  // for each bit in len2:
-  //    if bit set: M = M * PowerMatrix
-  //    PowerMatrix = PowerMatrix^2
-
-  // 或者更简单：直接运行 combine 逻辑，但针对矩阵操作
-  // 这里为了不破坏原有逻辑，我们重新复制一段简化版的 combine 逻辑用于生成矩阵
-
-  // Re-init odd/even for bits calculation
-  odd[0] = POLY;
-  row = 1;
-  for (int n = 1; n < 32; n++) {
-    odd[n] = row;
-    row <<= 1;
-  }
-  gf2_matrix_square(even, odd);
-  gf2_matrix_square(odd, even);
-
-  // Temp matrix for accumulation
-  uint32_t temp_mat[32];
-
+// ============== 高位增量枚举 ==============
+// 相邻 h 只有末尾若干位不同：h -> h + 1 时，末尾的 9 变 0、进位位加 1，
+// 所需 CRC(L) 只需异或这些位的增量 (平均约 1.1 次异或)，无需重算 CRC 与矩阵乘法
+typedef struct {
+  uint8_t digits[LOW_PART_DIGITS]; // digits[j]: 倒数第 j 位
+  int len;                         // 当前位数
+  uint32_t required;               // Target ^ M_8 * CRC(h)
+} HighEnum;
+
+static void high_enum_init(HighEnum *e, uint32_t target, uint32_t h) {
+  e->required = mitm_calculate_required_L_fast(target, crc32_digits_eval(h));
+  // 高于当前位数的位必须为 0：high_enum_next 靠 digits[len] != 9 结束进位
+  memset(e->digits, 0, sizeof(e->digits));
+  e->len = 0;
   do {
-    gf2_matrix_square(even, odd);
-    if (len2 & 1) {
-      // row_matrix = row_matrix * even
-      // 矩阵乘法: C[i] = times(A[i], B)
-      // 这里 row_matrix 是累积结果，even 是当前幂次
-      for (int i = 0; i < 32; i++) {
-        temp_mat[i] = gf2_matrix_times(even, row_matrix[i]);
-      }
-      memcpy(row_matrix, temp_mat, sizeof(temp_mat));
-    }
-    len2 >>= 1;
-    if (len2 == 0)
-      break;
-
-    gf2_matrix_square(odd, even);
-    if (len2 & 1) {
-      for (int i = 0; i < 32; i++) {
-        temp_mat[i] = gf2_matrix_times(odd, row_matrix[i]);
-      }
-      memcpy(row_matrix, temp_mat, sizeof(temp_mat));
-    }
-    len2 >>= 1;
-  } while (len2 != 0);
+    e->digits[e->len++] = (uint8_t)(h % 10);
+    h /= 10;
+  } while (h);
 }
 
-// 快速计算 L = Target ^ (H * M_8)
-// 使用预计算矩阵优化
-static uint32_t mitm_calculate_required_L_fast(uint32_t target,
-                                               uint32_t crc_h) {
-  // 计算 shifted_h = crc_h * g_shift_matrix_len8
-  uint32_t shifted_h = gf2_matrix_times(g_shift_matrix_len8, crc_h);
-  return target ^ shifted_h;
+// 前进到 h + 1 (调用者保证 h + 1 < 10^8)
+static inline void high_enum_next(HighEnum *e) {
+  int j = 0;
+  while (e->digits[j] == 9) {
+    e->required ^= g_shift_step[j][9];
+    e->digits[j++] = 0;
+  }
+  if (j == e->len) {
+    // 进位产生新的最高位 (0 -> 1)，同时切换长度常数
+    e->required ^= g_shift_len_delta[e->len];
+    e->digits[e->len++] = 0;
+  }
+  e->required ^= g_shift_step[j][e->digits[j]];
+  e->digits[j]++;
 }
 
-// 原始 combine (保留用于测试)
+// 原始 combine (保留用于测试)：CRC(A || B) = Shift_|B|(CRC(A)) ^ CRC(B)
 static uint32_t crc32_combine_zlib(uint32_t crc1, uint32_t crc2, int64_t len2) {
-  uint32_t odd[32];  // 奇数幂矩阵
-  uint32_t even[32]; // 偶数幂矩阵
-
   // 边界检查
   if (len2 <= 0)
     return crc1;
 
-  // 初始化 odd 为 x^1 的矩阵表示
-  odd[0] = POLY;
-  uint32_t row = 1;
-  for (int n = 1; n < 32; n++) {
-    odd[n] = row;
-    row <<= 1;
-  }
-
-  // 计算 even = odd^2 = x^2
-  gf2_matrix_square(even, odd);
-  // 计算 odd = even^2 = x^4
-  gf2_matrix_square(odd, even);
-
-  // 应用 len2 个零字节的位移
-  do {
-    gf2_matrix_square(even, odd);
-    if (len2 & 1)
-      crc1 = gf2_matrix_times(even, crc1);
-    len2 >>= 1;
-
-    if (len2 == 0)
-      break;
-
-    gf2_matrix_square(odd, even);
-    if (len2 & 1)
-      crc1 = gf2_matrix_times(odd, crc1);
-    len2 >>= 1;
-  } while (len2 != 0);
+  // 任意长度的移位都由同一算子完成
+  Crc32ShiftOp op;
+  crc32_shift_op_init(&op, (uint64_t)len2);
 
   // 组合: shifted(crc1) ^ crc2
-  crc1 ^= crc2;
-  return crc1;
+  return crc32_shift_apply(&op, crc1) ^ crc2;
 }
 
 // MITM 反推 (兼容旧接口，保留)
@@ -237,12 +238,7 @@ static uint32_t mitm_calculate_required_L(uint32_t target, uint32_t crc_h,
 // ============== MITM 逻辑验证测试 ==============
 // 计算字符串的 CRC32 (测试辅助函数)
 static uint32_t crc32_test_string(const char *str) {
-  uint32_t crc = 0xFFFFFFFF;
-  while (*str) {
-    crc = crc32_table[(crc ^ *str) & 0xFF] ^ (crc >> 8);
-    str++;
-  }
-  return crc ^ 0xFFFFFFFF;
+  return crc32_fast(str, strlen(str));
 }
 
 void test_mitm_logic(void) {
@@ -276,331 +272,2184 @@ void test_mitm_logic(void) {
   }
 }
 
-// ============== 排序与二分搜索 ==============
+// ============== 成员过滤器 ==============
+// 10^8 个键只占 2^32 空间的约 2.3%，绝大多数探测都不会命中
+// 探测前先查过滤器，不存在的键只需访问一条缓存行即可排除
+
+static uint64_t filter_bytes(MitmFilter kind) {
+  switch (kind) {
+  case MITM_FILTER_BLOOM:
+    return (uint64_t)1 << (BLOOM_BITS_LOG2 - 3);
+  case MITM_FILTER_BITMAP:
+    return (uint64_t)1 << (32 - 3);
+  default:
+    return 0;
+  }
+}
+
+// 布隆过滤器块内位置：CRC 本身已充分混合，乘法散列后按 9 位切片
+static inline uint32_t bloom_mix(uint32_t crc) { return crc * 0x9E3779B1u; }
+
+static inline void filter_add(uint64_t *filter, MitmFilter kind,
+                              uint32_t crc) {
+  if (kind == MITM_FILTER_BITMAP) {
+    filter[crc >> 6] |= (uint64_t)1 << (crc & 63);
+  } else if (kind == MITM_FILTER_BLOOM) {
+    uint64_t *block = filter + (size_t)(crc >> BLOOM_BLOCK_SHIFT) * 8;
+    uint32_t mix = bloom_mix(crc);
+    for (int k = 0; k < BLOOM_HASHES; k++) {
+      uint32_t bit = (mix >> (9 * k)) & (BLOOM_BLOCK_BITS - 1);
+      block[bit >> 6] |= (uint64_t)1 << (bit & 63);
+    }
+  }
+}
 
-// 比较函数用于 qsort
-static int crc_entry_compare(const void *a, const void *b) {
-  const CrcEntry *ea = (const CrcEntry *)a;
-  const CrcEntry *eb = (const CrcEntry *)b;
-  if (ea->crc < eb->crc)
-    return -1;
-  if (ea->crc > eb->crc)
-    return 1;
-  return 0;
+// 返回 0 表示键一定不在表中
+static inline int filter_may_contain(uint32_t crc) {
+  if (g_filter_kind == MITM_FILTER_BITMAP)
+    return (int)((g_filter[crc >> 6] >> (crc & 63)) & 1);
+  if (g_filter_kind == MITM_FILTER_BLOOM) {
+    const uint64_t *block = g_filter + (size_t)(crc >> BLOOM_BLOCK_SHIFT) * 8;
+    uint32_t mix = bloom_mix(crc);
+    for (int k = 0; k < BLOOM_HASHES; k++) {
+      uint32_t bit = (mix >> (9 * k)) & (BLOOM_BLOCK_BITS - 1);
+      if (!((block[bit >> 6] >> (bit & 63)) & 1))
+        return 0;
+    }
+  }
+  return 1;
 }
 
-// 二分搜索
-// 改为：在预计算表中查找所有匹配的 low 值
+// ============== 分桶索引查找 ==============
+
+// 在分桶索引中查找所有匹配的 low 值
 // 返回找到的数量，结果存入 low_results 数组
+// 一次查找只触及桶偏移、桶内 rem 字节与命中项的 low 共 2-3 条缓存行；
+// 过滤器排除的键只触及过滤器的一条缓存行
 static int find_candidates(uint32_t target_crc, uint32_t *low_results,
                            int max_results) {
-  int left = 0;
-  int right = TABLE_ENTRY_COUNT - 1;
+  if (!filter_may_contain(target_crc))
+    return 0;
+
+  uint32_t bucket = target_crc >> MITM_REM_BITS;
+  uint8_t rem = (uint8_t)target_crc;
+  uint32_t end = g_bucket[bucket + 1];
   int count = 0;
 
-  while (left <= right) {
-    int mid = left + (right - left) / 2;
-    if (g_mitm_table[mid].crc == target_crc) {
-      // 找到了一个匹配项，需要向左右扩展查找所有相同的 CRC
+  for (uint32_t i = g_bucket[bucket]; i < end; i++) {
+    if (g_rem[i] == rem && count < max_results) {
+      low_results[count++] = g_low[i];
+    }
+  }
+  return count;
+}
 
-      // 1. 向左查找起始位置
-      int start = mid;
-      while (start > 0 && g_mitm_table[start - 1].crc == target_crc) {
-        start--;
+// 批量探测的一条命中：keys 中的下标与对应的低位
+typedef struct {
+  uint32_t index;
+  uint32_t low;
+} ProbeHit;
+
+// 批量探测 n (<= PROBE_BATCH_MAX) 个键，命中按键下标升序写入 hits
+// 逐个探测时每个键都要等一次内存延迟；这里分三遍推进，
+// 每一遍都先为整批发出预取，使多次缓存缺失同时在途：
+//   1. 预取过滤器行 (无过滤器时直接预取桶偏移)
+//   2. 过滤器放行的键预取桶偏移 (约 2.3% + 误判)
+//   3. 读取桶范围并预取 rem，最后逐桶比对
+// 每个键最多保留 16 个命中，与 find_candidates 一致
+static int probe_batch(const uint32_t *keys, int n, ProbeHit *hits) {
+  uint32_t live[PROBE_BATCH_MAX];
+  uint32_t begin[PROBE_BATCH_MAX];
+  uint32_t end[PROBE_BATCH_MAX];
+  int live_count = 0;
+
+  if (g_filter) {
+    for (int i = 0; i < n; i++) {
+      if (g_filter_kind == MITM_FILTER_BITMAP)
+        MITM_PREFETCH(g_filter + (keys[i] >> 6));
+      else
+        MITM_PREFETCH(g_filter + (size_t)(keys[i] >> BLOOM_BLOCK_SHIFT) * 8);
+    }
+    for (int i = 0; i < n; i++) {
+      if (filter_may_contain(keys[i])) {
+        live[live_count++] = (uint32_t)i;
+        MITM_PREFETCH(g_bucket + (keys[i] >> MITM_REM_BITS));
       }
+    }
+  } else {
+    for (int i = 0; i < n; i++) {
+      live[live_count++] = (uint32_t)i;
+      MITM_PREFETCH(g_bucket + (keys[i] >> MITM_REM_BITS));
+    }
+  }
 
-      // 2. 向右查找结束位置
-      int end = mid;
-      while (end < TABLE_ENTRY_COUNT - 1 &&
-             g_mitm_table[end + 1].crc == target_crc) {
-        end++;
-      }
+  for (int k = 0; k < live_count; k++) {
+    uint32_t bucket = keys[live[k]] >> MITM_REM_BITS;
+    begin[k] = g_bucket[bucket];
+    end[k] = g_bucket[bucket + 1];
+    MITM_PREFETCH(g_rem + begin[k]);
+  }
 
-      // 3. 收集所有结果
-      for (int i = start; i <= end && count < max_results; i++) {
-        low_results[count++] = g_mitm_table[i].low;
+  int hit_count = 0;
+  for (int k = 0; k < live_count; k++) {
+    uint8_t rem = (uint8_t)keys[live[k]];
+    int found = 0;
+    for (uint32_t i = begin[k]; i < end[k]; i++) {
+      if (g_rem[i] == rem && found < 16) {
+        hits[hit_count].index = live[k];
+        hits[hit_count].low = g_low[i];
+        hit_count++;
+        found++;
       }
-      return count;
-    }
-    if (g_mitm_table[mid].crc < target_crc) {
-      left = mid + 1;
-    } else {
-      right = mid - 1;
     }
   }
-  return 0;
+  return hit_count;
 }
 
 // ============== 预计算表构建 ==============
 
-static int build_table(void) {
-  printf("[MITM] Building lookup table (%zu MB)...\n",
-         TABLE_SIZE_BYTES / (1024 * 1024));
-  clock_t start = clock();
+// 墙钟计时 (多线程下 clock() 在 POSIX 上统计的是 CPU 时间)
+static double wall_seconds(void) {
+#ifdef _WIN32
+  LARGE_INTEGER freq, now;
+  QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&now);
+  return (double)now.QuadPart / (double)freq.QuadPart;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
 
-// 并行计算
-#pragma omp parallel for
-  for (int i = 0; i < TABLE_ENTRY_COUNT; i++) {
-    g_mitm_table[i].crc = crc32_numeric_padded(i, LOW_PART_DIGITS);
-    g_mitm_table[i].low = i;
+// 单个 8 位补零低位串的 CRC32：利用仿射性质逐位异或贡献 (见 crc32_digits.h)
+static inline uint32_t low_key_crc(const Crc32DigitTables *t, uint32_t low) {
+  uint32_t crc = t->base[LOW_PART_DIGITS];
+  for (int j = 0; j < LOW_PART_DIGITS; j++) {
+    crc ^= t->contrib[j][low % 10];
+    low /= 10;
   }
+  return crc;
+}
 
-  // 按 CRC 排序
-  printf("[MITM] Sorting table...\n");
-  qsort(g_mitm_table, TABLE_ENTRY_COUNT, sizeof(CrcEntry), crc_entry_compare);
+// 计算 [base, base + n) 内各低位 (8 位补零串) 的 CRC32，n <= BUILD_BATCH
+// 按仿射性质嵌套累加：高 7 位的贡献之和 prefix 随进位增量更新，
+// 同一前缀下的 10 项只差末位贡献，内层循环为 10 路独立异或 (可向量化)
+static void hash_low_batch(uint32_t base, int n, uint32_t *crcs) {
+  const Crc32DigitTables *t = crc32_digits_tables();
+  const uint32_t *last = t->contrib[0];
+
+  // digit[j] 为倒数第 j 位 (j = 1..7)
+  uint8_t digit[LOW_PART_DIGITS];
+  uint32_t prefix = t->base[LOW_PART_DIGITS];
+  uint32_t v = base / 10;
+  for (int j = 1; j < LOW_PART_DIGITS; j++) {
+    digit[j] = (uint8_t)(v % 10);
+    prefix ^= t->contrib[j][digit[j]];
+    v /= 10;
+  }
 
-  clock_t end = clock();
-  double elapsed = (double)(end - start) / CLOCKS_PER_SEC;
-  printf("[MITM] Table build complete, took %.2f seconds\n", elapsed);
+  int d = (int)(base % 10);
+  int i = 0;
+  while (i < n) {
+    if (d == 0 && n - i >= 10) {
+      for (int k = 0; k < 10; k++)
+        crcs[i + k] = prefix ^ last[k];
+      i += 10;
+    } else {
+      // 批次首尾不足 10 项的部分
+      int span = 10 - d < n - i ? 10 - d : n - i;
+      for (int k = 0; k < span; k++)
+        crcs[i + k] = prefix ^ last[d + k];
+      i += span;
+    }
+    d = 0;
+
+    // 前缀加一 (十进制进位)
+    for (int j = 1; j < LOW_PART_DIGITS; j++) {
+      prefix ^= t->contrib[j][digit[j]];
+      digit[j] = digit[j] == 9 ? 0 : digit[j] + 1;
+      prefix ^= t->contrib[j][digit[j]];
+      if (digit[j])
+        break;
+    }
+  }
+}
 
-  return 0;
+// 建表切片：第一轮中一个连续的低位区间
+typedef struct {
+  uint32_t begin;
+  uint32_t end;
+  uint32_t cursor[BUILD_PART_COUNT]; // 计数阶段为各分区项数，散列阶段为写游标
+  uint32_t *low;                     // 分区暂存区 (直接借用最终 low 数组)
+} BuildSlice;
+
+// 建表分区：第二轮中 CRC 高 8 位相同的一段表项
+typedef struct {
+  uint32_t begin; // 分区在表中的起止位置
+  uint32_t end;
+  uint32_t part;
+  uint32_t *bucket;
+  uint8_t *rem;
+  uint32_t *low;
+  uint64_t *filter; // 分区覆盖连续的 CRC 区间，写入的过滤器字也互不重叠
+  MitmFilter filter_kind;
+  int failed; // 内存不足
+} BuildPart;
+
+// 第一轮计数：统计切片内各粗分区的项数
+static void build_count_worker(void *arg) {
+  BuildSlice *slice = (BuildSlice *)arg;
+  uint32_t crcs[BUILD_BATCH];
+
+  memset(slice->cursor, 0, sizeof(slice->cursor));
+  for (uint32_t base = slice->begin; base < slice->end; base += BUILD_BATCH) {
+    int n = (int)(slice->end - base < BUILD_BATCH ? slice->end - base
+                                                  : BUILD_BATCH);
+    hash_low_batch(base, n, crcs);
+    for (int i = 0; i < n; i++) {
+      slice->cursor[crcs[i] >> (32 - BUILD_PART_BITS)]++;
+    }
+  }
 }
 
-// 保存表到文件
-static int save_table(const char *path) {
-  FILE *f = fopen(path, "wb");
-  if (!f) {
-    fprintf(stderr, "[MITM] Failed to create cache: %s\n", path);
-    return -1;
+// 第一轮散列：把低位按粗分区写入暂存区 (切片按序排列，分区内 low 升序)
+static void build_scatter_worker(void *arg) {
+  BuildSlice *slice = (BuildSlice *)arg;
+  uint32_t crcs[BUILD_BATCH];
+
+  for (uint32_t base = slice->begin; base < slice->end; base += BUILD_BATCH) {
+    int n = (int)(slice->end - base < BUILD_BATCH ? slice->end - base
+                                                  : BUILD_BATCH);
+    hash_low_batch(base, n, crcs);
+    for (int i = 0; i < n; i++) {
+      slice->low[slice->cursor[crcs[i] >> (32 - BUILD_PART_BITS)]++] =
+          base + (uint32_t)i;
+    }
+  }
+}
+
+// 第二轮：分区内按完整桶号做计数排序 (稳定，桶内 low 保持升序)
+// 各分区只写自己的桶区间与表项区间，互不重叠
+static void build_part_worker(void *arg) {
+  BuildPart *part = (BuildPart *)arg;
+  const Crc32DigitTables *t = crc32_digits_tables();
+  uint32_t n = part->end - part->begin;
+  uint32_t first = part->part * BUILD_PART_BUCKETS;
+  uint32_t *bucket = part->bucket + first;
+
+  uint32_t *lows = (uint32_t *)malloc((size_t)n * sizeof(uint32_t) + 1);
+  uint32_t *crcs = (uint32_t *)malloc((size_t)n * sizeof(uint32_t) + 1);
+  uint32_t *cursor = (uint32_t *)malloc(BUILD_PART_BUCKETS * sizeof(uint32_t));
+  if (!lows || !crcs || !cursor) {
+    free(lows);
+    free(crcs);
+    free(cursor);
+    part->failed = 1;
+    return;
   }
 
-  // 写入魔数和版本
-  uint32_t magic = 0x4D49544D; // "MITM"
-  uint32_t version = 1;
-  fwrite(&magic, sizeof(magic), 1, f);
-  fwrite(&version, sizeof(version), 1, f);
+  // 取出暂存的低位并重算 CRC (分区内不连续，逐项查贡献表)
+  memcpy(lows, part->low + part->begin, (size_t)n * sizeof(uint32_t));
+  memset(bucket, 0, BUILD_PART_BUCKETS * sizeof(uint32_t));
+  for (uint32_t i = 0; i < n; i++) {
+    crcs[i] = low_key_crc(t, lows[i]);
+    bucket[(crcs[i] >> MITM_REM_BITS) - first]++;
+  }
 
-  // 写入表数据
-  size_t written = fwrite(g_mitm_table, sizeof(CrcEntry), TABLE_ENTRY_COUNT, f);
-  fclose(f);
+  // 分区内前缀和：bucket[b] 变为桶起始偏移
+  uint32_t offset = part->begin;
+  for (uint32_t b = 0; b < BUILD_PART_BUCKETS; b++) {
+    uint32_t size = bucket[b];
+    bucket[b] = offset;
+    offset += size;
+  }
 
-  if (written != TABLE_ENTRY_COUNT) {
-    fprintf(stderr, "[MITM] Failed to write cache file\n");
-    return -1;
+  // 散列写入 (写游标单独维护，bucket 中保留起始偏移)
+  memcpy(cursor, bucket, BUILD_PART_BUCKETS * sizeof(uint32_t));
+  for (uint32_t i = 0; i < n; i++) {
+    uint32_t pos = cursor[(crcs[i] >> MITM_REM_BITS) - first]++;
+    part->rem[pos] = (uint8_t)crcs[i];
+    part->low[pos] = lows[i];
+    filter_add(part->filter, part->filter_kind, crcs[i]);
   }
 
-  printf("[MITM] Cache saved to %s\n", path);
-  return 0;
+  free(cursor);
+  free(lows);
+  free(crcs);
 }
 
-// 从文件加载表
-static int load_table(const char *path) {
-  FILE *f = fopen(path, "rb");
-  if (!f)
+// 两轮并行基数排序建索引 (MSD：先按 CRC 高 8 位粗分区，再在分区内按桶细分)
+// 第一轮暂存直接借用 low 数组，无需额外的 400 MB 临时空间；
+// 结果与串行计数排序逐字节相同 (桶内 low 升序)，与线程数无关
+static int build_table(uint32_t *bucket, uint8_t *rem, uint32_t *low,
+                       uint64_t *filter, MitmFilter filter_kind) {
+  printf("[MITM] Building lookup table (%zu MB)...\n",
+         TABLE_SIZE_BYTES / (1024 * 1024));
+  double start = wall_seconds();
+  crc32_digits_init();
+
+  BuildSlice *slices = (BuildSlice *)calloc(BUILD_SLICES, sizeof(BuildSlice));
+  BuildPart *parts = (BuildPart *)calloc(BUILD_PART_COUNT, sizeof(BuildPart));
+  if (!slices || !parts) {
+    free(slices);
+    free(parts);
     return -1;
+  }
 
-  // 检查魔数和版本
-  uint32_t magic, version;
-  if (fread(&magic, sizeof(magic), 1, f) != 1 ||
-      fread(&version, sizeof(version), 1, f) != 1 || magic != 0x4D49544D ||
-      version != 1) {
-    fclose(f);
+  for (int s = 0; s < BUILD_SLICES; s++) {
+    slices[s].begin = (uint32_t)((uint64_t)TABLE_ENTRY_COUNT * s / BUILD_SLICES);
+    slices[s].end =
+        (uint32_t)((uint64_t)TABLE_ENTRY_COUNT * (s + 1) / BUILD_SLICES);
+    slices[s].low = low;
+  }
+
+  // 第一轮：并行计数
+  if (thread_pool_run(build_count_worker, slices, sizeof(BuildSlice),
+                      BUILD_SLICES) != 0) {
+    free(slices);
+    free(parts);
     return -1;
   }
 
-  // 读取表数据
-  size_t read = fread(g_mitm_table, sizeof(CrcEntry), TABLE_ENTRY_COUNT, f);
-  fclose(f);
+  // 前缀和 (分区优先、切片其次)：cursor 变为各切片在各分区中的写入起点
+  uint32_t offset = 0;
+  for (uint32_t p = 0; p < BUILD_PART_COUNT; p++) {
+    parts[p].begin = offset;
+    for (int s = 0; s < BUILD_SLICES; s++) {
+      uint32_t size = slices[s].cursor[p];
+      slices[s].cursor[p] = offset;
+      offset += size;
+    }
+    parts[p].end = offset;
+    parts[p].part = p;
+    parts[p].bucket = bucket;
+    parts[p].rem = rem;
+    parts[p].low = low;
+    parts[p].filter = filter;
+    parts[p].filter_kind = filter_kind;
+  }
 
-  if (read != TABLE_ENTRY_COUNT) {
-    return -1;
+  // 第一轮：并行散列到粗分区
+  printf("[MITM] Scattering into buckets...\n");
+  int rc = thread_pool_run(build_scatter_worker, slices, sizeof(BuildSlice),
+                           BUILD_SLICES);
+
+  // 第二轮：各分区并行细分到桶
+  if (rc == 0)
+    rc = thread_pool_run(build_part_worker, parts, sizeof(BuildPart),
+                         BUILD_PART_COUNT);
+  for (uint32_t p = 0; rc == 0 && p < BUILD_PART_COUNT; p++) {
+    if (parts[p].failed) {
+      fprintf(stderr, "[MITM] Memory allocation failed during build\n");
+      rc = -1;
+    }
   }
+  bucket[MITM_BUCKET_COUNT] = TABLE_ENTRY_COUNT;
 
-  printf("[MITM] Loaded lookup table from cache\n");
+  free(slices);
+  free(parts);
+  if (rc != 0)
+    return -1;
+
+  printf("[MITM] Table build complete, took %.2f seconds\n",
+         wall_seconds() - start);
   return 0;
 }
 
-// ============== 公共接口实现 ==============
-
-int mitm_init(const char *cache_path) {
-  if (g_mitm_ready)
-    return 0;
+// ============== 表镜像与缓存文件 ==============
+// 缓存文件 (v4) 与内存中的表镜像布局完全一致：
+//   [文件头，占满第一页][桶偏移][rem 字节数组][low 数组][成员过滤器 (可选)]
+// 各段起始偏移按页对齐，整文件可直接只读映射使用
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t endian_tag; // TABLE_ENDIAN_TAG
+  uint32_t entry_count;
+  uint32_t bucket_bits;
+  uint32_t page_size;
+  uint64_t bucket_offset;
+  uint64_t rem_offset;
+  uint64_t low_offset;
+  uint32_t filter_kind; // MitmFilter
+  uint32_t reserved;
+  uint64_t filter_offset;
+  uint64_t filter_bytes;
+  uint64_t file_size;
+} TableHeader;
+
+static uint64_t align_page(uint64_t offset) {
+  return (offset + TABLE_PAGE - 1) & ~(uint64_t)(TABLE_PAGE - 1);
+}
 
-  if (!cache_path)
-    cache_path = DEFAULT_CACHE_PATH;
+// 按当前参数计算表镜像布局
+static void table_layout(TableHeader *header) {
+  memset(header, 0, sizeof(*header));
+  header->magic = TABLE_MAGIC;
+  header->version = TABLE_VERSION;
+  header->endian_tag = TABLE_ENDIAN_TAG;
+  header->entry_count = TABLE_ENTRY_COUNT;
+  header->bucket_bits = MITM_BUCKET_BITS;
+  header->page_size = TABLE_PAGE;
+  header->bucket_offset = TABLE_PAGE;
+  header->rem_offset =
+      align_page(header->bucket_offset + BUCKET_OFFSETS_BYTES);
+  header->low_offset = align_page(header->rem_offset + TABLE_ENTRY_COUNT);
+  header->filter_kind = (uint32_t)g_config.filter;
+  header->filter_offset = align_page(
+      header->low_offset + (uint64_t)TABLE_ENTRY_COUNT * sizeof(uint32_t));
+  header->filter_bytes = filter_bytes(g_config.filter);
+  header->file_size = header->filter_offset + header->filter_bytes;
+}
 
-  // CRC32 表已在 crc32_core.h 中静态初始化
+// 校验文件头与文件大小，不匹配返回 -1
+static int check_header(const TableHeader *header, uint64_t file_size) {
+  if (header->magic != TABLE_MAGIC)
+    return -1;
 
-  // 分配内存
-  g_mitm_table = (CrcEntry *)malloc(TABLE_SIZE_BYTES);
-  if (!g_mitm_table) {
-    fprintf(stderr, "[MITM] Memory allocation failed (%zu MB)\n",
-            TABLE_SIZE_BYTES / (1024 * 1024));
+  TableHeader expect;
+  table_layout(&expect);
+  if (header->version != TABLE_VERSION) {
+    printf("[MITM] Cache format v%u is outdated, rebuilding...\n",
+           header->version);
     return -1;
   }
-
-  // 尝试从缓存加载
-  if (load_table(cache_path) == 0) {
-    // 即使从缓存加载，也必须进行预计算
-    precompute_shift_matrix(g_shift_matrix_len8, LOW_PART_DIGITS);
-    g_mitm_ready = 1;
-    return 0;
+  if (header->endian_tag != TABLE_ENDIAN_TAG) {
+    printf("[MITM] Cache was written on a different byte order, "
+           "rebuilding...\n");
+    return -1;
   }
-
-  // 缓存不存在，构建表
-  if (build_table() != 0) {
-    free(g_mitm_table);
-    g_mitm_table = NULL;
+  if (header->filter_kind != expect.filter_kind) {
+    printf("[MITM] Cache filter (%s) differs from configuration (%s), "
+           "rebuilding...\n",
+           mitm_filter_name((MitmFilter)header->filter_kind),
+           mitm_filter_name(g_config.filter));
     return -1;
   }
+  if (memcmp(header, &expect, sizeof(expect)) != 0 ||
+      file_size < header->file_size) {
+    return -1;
+  }
+  return 0;
+}
 
-  // 保存缓存
-  save_table(cache_path);
-
-  // 预计算 len=8 的位移矩阵 (Critical for performance)
-  precompute_shift_matrix(g_shift_matrix_len8, LOW_PART_DIGITS);
+// 绑定镜像中的三段数据，末尾偏移必须等于表项总数，否则文件已损坏
+static int attach_image(uint8_t *image, size_t size, size_t alloc_size,
+                        MitmBacking backing) {
+  const TableHeader *header = (const TableHeader *)image;
+  const uint32_t *bucket = (const uint32_t *)(image + header->bucket_offset);
+  if (bucket[MITM_BUCKET_COUNT] != TABLE_ENTRY_COUNT)
+    return -1;
 
-  g_mitm_ready = 1;
+  g_image = image;
+  g_image_size = size;
+  g_alloc_size = alloc_size;
+  g_backing = backing;
+  g_bucket = bucket;
+  g_rem = image + header->rem_offset;
+  g_low = (const uint32_t *)(image + header->low_offset);
+  g_filter_kind = (MitmFilter)header->filter_kind;
+  g_filter = header->filter_bytes
+                 ? (const uint64_t *)(image + header->filter_offset)
+                 : NULL;
   return 0;
 }
 
-// 智能 UID 过滤器
-// 基于真实用户数据的白名单 (数据来源: B站热门视频评论区)
-// 采集 457 用户，筛选出 71 个 16 位 UID，分析前缀分布
-static int is_likely_valid_uid(uint64_t uid) {
-  // 1. Legacy UID (0 ~ 2.2B)
-  if (uid > 0 && uid <= 2200000000ULL) {
-    return 1;
+#ifdef _WIN32
+// 在进程令牌中启用 "锁定内存页" 权限 (SeLockMemoryPrivilege)
+// 账户被授予该权限还不够，须在令牌中启用后 MEM_LARGE_PAGES 分配才能成功
+// 返回 ERROR_SUCCESS 或 GetLastError 错误码 (未授予时为 ERROR_NOT_ALL_ASSIGNED)
+static DWORD enable_lock_memory_privilege(void) {
+  static int done = 0;
+  static DWORD result = ERROR_SUCCESS;
+  if (done)
+    return result;
+  done = 1;
+
+  HANDLE token;
+  if (!OpenProcessToken(GetCurrentProcess(),
+                        TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token)) {
+    result = GetLastError();
+    return result;
   }
+  TOKEN_PRIVILEGES privileges;
+  privileges.PrivilegeCount = 1;
+  privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+  if (LookupPrivilegeValueA(NULL, "SeLockMemoryPrivilege",
+                            &privileges.Privileges[0].Luid))
+    AdjustTokenPrivileges(token, FALSE, &privileges, 0, NULL, NULL);
+  // 任一步失败，或调用成功但账户未被授予该权限，GetLastError 都会给出原因
+  result = GetLastError();
+  CloseHandle(token);
+  return result;
+}
+#endif
 
-  // 2. 16位 Snowflake UID - 基于实测数据的前缀白名单 (5位粒度)
-  // 数据来源: B站热门视频评论区 (445样本, 68有效)
-  if (uid >= 1000000000000000ULL && uid < 10000000000000000ULL) {
-    uint64_t prefix = uid / 100000000000ULL; // 取前5位
-    switch (prefix) {
-    case 34615:
-    case 34930:
-    case 34931:
-    case 34932:
-    case 34943:
-    case 35371:
-    case 35463:
-    case 35465:
-    case 35466:
-    case 35467:
-    case 35468:
-    case 35469:
-    case 36323:
-    case 36909:
-      return 1;
-    default:
-      return 0;
+// 分配可写的表镜像 (内容清零)
+// 请求大页时依次尝试：显式大页 (MAP_HUGETLB / MEM_LARGE_PAGES) ->
+// 2 MB 对齐的匿名映射 + 透明大页 (MADV_HUGEPAGE) -> 普通堆内存
+static uint8_t *alloc_image(size_t size, size_t *alloc_size,
+                            MitmBacking *backing) {
+  if (g_config.huge_pages) {
+#ifdef _WIN32
+    // 需要 "锁定内存页" 权限 (SeLockMemoryPrivilege)，否则分配失败
+    SIZE_T large = GetLargePageMinimum();
+    DWORD err = enable_lock_memory_privilege();
+    if (err != ERROR_SUCCESS) {
+      printf("[MITM] Cannot enable SeLockMemoryPrivilege (error %lu)\n",
+             (unsigned long)err);
+    } else if (large) {
+      size_t rounded = (size + large - 1) / large * large;
+      void *p = VirtualAlloc(NULL, rounded,
+                             MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                             PAGE_READWRITE);
+      if (p) {
+        *alloc_size = rounded;
+        *backing = MITM_BACKING_HUGE;
+        return (uint8_t *)p;
+      }
+      printf("[MITM] Large page allocation failed (error %lu)\n",
+             (unsigned long)GetLastError());
+    }
+#else
+#ifdef MAP_HUGETLB
+    // 显式大页需要系统预留 (vm.nr_hugepages)，不足时映射失败
+    size_t rounded = (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+    void *p = mmap(NULL, rounded, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED) {
+      *alloc_size = rounded;
+      *backing = MITM_BACKING_HUGE;
+      return (uint8_t *)p;
+    }
+#endif
+#ifdef MADV_HUGEPAGE
+    // 透明大页只作用于 2 MB 对齐的区间：多映射一页再裁掉首尾
+    size_t thp_rounded = (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+    uint8_t *raw = (uint8_t *)mmap(NULL, thp_rounded + HUGE_PAGE_SIZE,
+                                   PROT_READ | PROT_WRITE,
+                                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if ((void *)raw != MAP_FAILED) {
+      uint8_t *aligned = (uint8_t *)(((uintptr_t)raw + HUGE_PAGE_SIZE - 1) &
+                                     ~(uintptr_t)(HUGE_PAGE_SIZE - 1));
+      size_t head = (size_t)(aligned - raw);
+      if (head)
+        munmap(raw, head);
+      if (HUGE_PAGE_SIZE - head)
+        munmap(aligned + thp_rounded, HUGE_PAGE_SIZE - head);
+      madvise(aligned, thp_rounded, MADV_HUGEPAGE);
+      *alloc_size = thp_rounded;
+      *backing = MITM_BACKING_THP;
+      return aligned;
     }
+#endif
+#endif
+    printf("[MITM] Huge pages unavailable, using regular pages\n");
   }
 
-  // 3. 其他区间为噪音
-  return 0;
+  *alloc_size = size;
+  *backing = MITM_BACKING_HEAP;
+  return (uint8_t *)calloc(1, size);
 }
 
-int mitm_crack(const char *target_hash, MitmResult *result) {
-  if (!g_mitm_ready || !result)
-    return -1;
-
-  result->count = 0;
+// 按后备类型释放表镜像
+static void release_image(uint8_t *image, size_t alloc_size,
+                          MitmBacking backing) {
+  if (!image)
+    return;
 
-  // 动态分配结果数组（如果未分配）
-  if (result->uids == NULL) {
-    result->capacity = MAX_MITM_RESULTS;
-    result->uids = (uint64_t *)malloc(sizeof(uint64_t) * result->capacity);
-    if (result->uids == NULL) {
-      fprintf(stderr, "[MITM] Failed to allocate result buffer\n");
-      return -1;
-    }
+  switch (backing) {
+  case MITM_BACKING_MAPPED:
+#ifdef _WIN32
+    UnmapViewOfFile(image);
+    CloseHandle(g_map_handle);
+    g_map_handle = NULL;
+#else
+    munmap(image, alloc_size);
+#endif
+    break;
+  case MITM_BACKING_HUGE:
+  case MITM_BACKING_THP:
+#ifdef _WIN32
+    VirtualFree(image, 0, MEM_RELEASE);
+#else
+    munmap(image, alloc_size);
+#endif
+    break;
+  default:
+    free(image);
+    break;
   }
+}
 
-  // 解析目标哈希
-  uint32_t target = (uint32_t)strtoul(target_hash, NULL, 16);
-  printf("[MITM] Target hash: %08x\n", target);
+// 释放表镜像
+static void free_table(void) {
+  release_image(g_image, g_alloc_size, g_backing);
+  g_image = NULL;
+  g_image_size = 0;
+  g_alloc_size = 0;
+  g_backing = MITM_BACKING_NONE;
+  g_bucket = NULL;
+  g_rem = NULL;
+  g_low = NULL;
+  g_filter = NULL;
+  g_filter_kind = MITM_FILTER_NONE;
+}
 
-  clock_t start = clock();
-
-  // MITM 攻击核心逻辑
-  // 遍历 High Part (0 ~ 10^8)
-  for (uint32_t h = 0; h < LOW_PART_LIMIT; h++) {
-    // 快速数字转字符串（避免 sprintf）
-    char high_str[16];
-    int high_len = 0;
-    uint32_t temp = h;
-    if (temp == 0) {
-      high_str[0] = '0';
-      high_len = 1;
-    } else {
-      char rev[16];
-      while (temp > 0) {
-        rev[high_len++] = '0' + (temp % 10);
-        temp /= 10;
-      }
-      for (int i = 0; i < high_len; i++) {
-        high_str[i] = rev[high_len - 1 - i];
-      }
-    }
+// 保存表到文件：先写临时文件再原子替换，避免其他进程映射到半成品
+static int save_table(const char *path) {
+  char tmp_path[1024];
+  snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
 
-    // 计算 CRC(high_string)
-    uint32_t crc_h = 0xFFFFFFFF;
-    for (int i = 0; i < high_len; i++) {
-      crc_h = crc32_table[(crc_h ^ high_str[i]) & 0xFF] ^ (crc_h >> 8);
-    }
-    crc_h ^= 0xFFFFFFFF;
+  FILE *f = fopen(tmp_path, "wb");
+  if (!f) {
+    fprintf(stderr, "[MITM] Failed to create cache: %s\n", tmp_path);
+    return -1;
+  }
 
-    // 直接计算所需的 CRC(L) = Target ^ Shift(crc_h)
-    // 使用快速向量矩阵乘法 (Optimization)
-    uint32_t required_crc_l = mitm_calculate_required_L_fast(target, crc_h);
+  // 镜像即文件内容 (含文件头与页对齐填充)
+  int ok = fwrite(g_image, 1, g_image_size, f) == g_image_size;
+  ok = (fclose(f) == 0) && ok;
 
-    // 在预计算表中查找所有可能的 L (处理 CRC 碰撞)
-    uint32_t low_candidates[16]; // 一般碰撞很少超过 16 个
-    int candidate_count = find_candidates(required_crc_l, low_candidates, 16);
+#ifdef _WIN32
+  ok = ok && MoveFileExA(tmp_path, path, MOVEFILE_REPLACE_EXISTING);
+#else
+  ok = ok && rename(tmp_path, path) == 0;
+#endif
+  if (!ok) {
+    fprintf(stderr, "[MITM] Failed to write cache file\n");
+    remove(tmp_path);
+    return -1;
+  }
 
-    for (int i = 0; i < candidate_count; i++) {
-      uint32_t low = low_candidates[i];
+  printf("[MITM] Cache saved to %s\n", path);
+  return 0;
+}
 
-      // 组合完整 UID
-      uint64_t uid = (uint64_t)h * 100000000ULL + low;
+// 以只读方式映射缓存文件 (页缓存直接作为表，多进程共享同一份物理内存)
+// 返回 0=成功, -1=无法映射 (可退回整表读入), -2=文件内容无效 (需重建)
+static int map_table(const char *path) {
+#ifdef _WIN32
+  // FILE_SHARE_DELETE: 映射期间其他进程仍可用 MoveFileExA 替换缓存文件
+  HANDLE file =
+      CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                  NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE)
+    return -1;
 
-      // 智能过滤：仅保留可能的有效 UID
-      if (!is_likely_valid_uid(uid)) {
-        continue;
-      }
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file, &file_size) ||
+      (uint64_t)file_size.QuadPart < sizeof(TableHeader)) {
+    CloseHandle(file);
+    return -1;
+  }
 
-      // 验证 CRC
-      uint32_t verify_crc = crc32_numeric(uid);
-      if (verify_crc == target) {
-        if (result->count < result->capacity) {
-          result->uids[result->count++] = uid;
-          // 仅打印前 100 个结果
-          if (result->count <= 100) {
-            printf("[MITM] Found candidate: %I64u\n", uid);
-          } else if (result->count == 101) {
-            printf("[MITM] ... more results suppressed ...\n");
-          }
-        } else {
-          // Buffer full
-          static int warned_full = 0;
-          if (!warned_full) {
-            printf("[MITM] Warning: Result buffer full (%d)!\n",
-                   result->capacity);
-            warned_full = 1;
-          }
-        }
-      }
-    }
+  HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  CloseHandle(file); // 映射对象持有文件引用
+  if (!mapping)
+    return -1;
+
+  uint8_t *image = (uint8_t *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!image) {
+    CloseHandle(mapping);
+    return -1;
+  }
+  size_t size = (size_t)file_size.QuadPart;
+
+  if (check_header((const TableHeader *)image, (uint64_t)size) != 0 ||
+      attach_image(image, size, size, MITM_BACKING_MAPPED) != 0) {
+    UnmapViewOfFile(image);
+    CloseHandle(mapping);
+    return -2;
+  }
+  g_map_handle = mapping;
+
+  // 预读：逐页触碰一次，把整表调入页缓存
+  if (g_config.prefetch) {
+    volatile uint8_t sink = 0;
+    for (size_t off = 0; off < size; off += TABLE_PAGE)
+      sink ^= image[off];
+    (void)sink;
   }
+#else
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return -1;
 
-  clock_t end = clock();
-  double elapsed = (double)(end - start) / CLOCKS_PER_SEC;
-  printf("[MITM] Search complete, found %d candidates, took %.2f seconds\n",
-         result->count, elapsed);
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < sizeof(TableHeader)) {
+    close(fd);
+    return -1;
+  }
+  size_t size = (size_t)st.st_size;
 
-  return result->count;
-}
+  int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+  if (g_config.prefetch)
+    flags |= MAP_POPULATE;
+#endif
+  void *mapped = mmap(NULL, size, PROT_READ, flags, fd, 0);
+  close(fd); // 映射建立后即可关闭描述符
+  if (mapped == MAP_FAILED)
+    return -1;
+  uint8_t *image = (uint8_t *)mapped;
 
-void mitm_cleanup(void) {
-  if (g_mitm_table) {
-    free(g_mitm_table);
-    g_mitm_table = NULL;
+  if (check_header((const TableHeader *)image, (uint64_t)size) != 0 ||
+      attach_image(image, size, size, MITM_BACKING_MAPPED) != 0) {
+    munmap(mapped, size);
+    return -2;
   }
-  g_mitm_ready = 0;
-}
 
-int mitm_is_ready(void) { return g_mitm_ready; }
+  // 预读整表，或声明随机访问以关闭无用的顺序预读
+  madvise(mapped, size, g_config.prefetch ? MADV_WILLNEED : MADV_RANDOM);
+#endif
 
-size_t mitm_get_table_size_mb(void) { return TABLE_SIZE_BYTES / (1024 * 1024); }
+  printf("[MITM] Mapped lookup table from cache (%zu MB)\n",
+         size / (1024 * 1024));
+  return 0;
+}
+
+// 从文件整表读入堆内存 (禁用映射或映射失败时使用)
+static int load_table(const char *path) {
+  FILE *f = fopen(path, "rb");
+  if (!f)
+    return -1;
+
+  // 检查魔数、版本、字节序与布局
+  TableHeader header;
+  fseek(f, 0, SEEK_END);
+  long file_size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  if (file_size < (long)sizeof(header) ||
+      fread(&header, sizeof(header), 1, f) != 1 ||
+      check_header(&header, (uint64_t)file_size) != 0) {
+    fclose(f);
+    return -1;
+  }
+
+  size_t size = (size_t)header.file_size;
+  size_t alloc_size;
+  MitmBacking backing;
+  uint8_t *image = alloc_image(size, &alloc_size, &backing);
+  if (!image) {
+    fclose(f);
+    return -1;
+  }
+
+  // 读取表镜像
+  fseek(f, 0, SEEK_SET);
+  int ok = fread(image, 1, size, f) == size;
+  fclose(f);
+
+  if (!ok || attach_image(image, size, alloc_size, backing) != 0) {
+    release_image(image, alloc_size, backing);
+    return -1;
+  }
+
+  printf("[MITM] Loaded lookup table from cache\n");
+  return 0;
+}
+
+// 在堆内存中构建新的表镜像
+static int build_image(void) {
+  TableHeader header;
+  table_layout(&header);
+
+  size_t size = (size_t)header.file_size;
+  size_t alloc_size;
+  MitmBacking backing;
+  uint8_t *image = alloc_image(size, &alloc_size, &backing);
+  if (!image) {
+    fprintf(stderr, "[MITM] Memory allocation failed (%zu MB)\n",
+            size / (1024 * 1024));
+    return -1;
+  }
+  memcpy(image, &header, sizeof(header));
+
+  if (build_table((uint32_t *)(image + header.bucket_offset),
+                  image + header.rem_offset,
+                  (uint32_t *)(image + header.low_offset),
+                  (uint64_t *)(image + header.filter_offset),
+                  (MitmFilter)header.filter_kind) != 0 ||
+      attach_image(image, size, alloc_size, backing) != 0) {
+    release_image(image, alloc_size, backing);
+    return -1;
+  }
+  return 0;
+}
+
+// ============== 大页统计 ==============
+
+// 统计表镜像中实际由大页映射的字节数
+// 显式大页整块都是大页；其余情况在 Linux 上按 /proc/self/smaps 中
+// 与镜像重叠的映射区累加 AnonHugePages / FilePmdMapped (透明大页)
+static size_t measure_huge_bytes(void) {
+  if (!g_image)
+    return 0;
+  if (g_backing == MITM_BACKING_HUGE)
+    return g_image_size;
+
+#ifdef __linux__
+  FILE *f = fopen("/proc/self/smaps", "r");
+  if (!f)
+    return 0;
+
+  uintptr_t lo = (uintptr_t)g_image;
+  uintptr_t hi = lo + g_alloc_size;
+  int overlap = 0;
+  size_t total = 0;
+  char line[512];
+  while (fgets(line, sizeof(line), f)) {
+    unsigned long start, end, kb;
+    // 映射区标题行形如 "start-end perms ..."
+    if (sscanf(line, "%lx-%lx ", &start, &end) == 2) {
+      overlap = start < hi && end > lo;
+    } else if (overlap && (sscanf(line, "AnonHugePages: %lu kB", &kb) == 1 ||
+                           sscanf(line, "FilePmdMapped: %lu kB", &kb) == 1)) {
+      total += (size_t)kb * 1024;
+    }
+  }
+  fclose(f);
+  // 重叠的映射区可能超出镜像范围，按镜像大小截断
+  return total < g_image_size ? total : g_image_size;
+#else
+  return 0;
+#endif
+}
+
+static const char *backing_name(MitmBacking backing) {
+  switch (backing) {
+  case MITM_BACKING_HEAP:
+    return "heap";
+  case MITM_BACKING_MAPPED:
+    return "file-mapped";
+  case MITM_BACKING_HUGE:
+    return "huge-pages";
+  case MITM_BACKING_THP:
+    return "transparent-huge-pages";
+  default:
+    return "none";
+  }
+}
+
+// 请求大页时打印实际的大页覆盖情况
+static void report_backing(void) {
+  if (!g_config.huge_pages)
+    return;
+
+  MitmStats stats;
+  mitm_get_stats(&stats);
+  printf("[MITM] Table backing: %s, %zu of %zu MB on huge pages "
+         "(%zu x %zu KB)\n",
+         backing_name(stats.backing), stats.huge_bytes / (1024 * 1024),
+         stats.table_bytes / (1024 * 1024), stats.huge_pages,
+         stats.huge_page_size / 1024);
+}
+
+// ============== 公共接口实现 ==============
+
+const char *mitm_filter_name(MitmFilter filter) {
+  switch (filter) {
+  case MITM_FILTER_NONE:
+    return "none";
+  case MITM_FILTER_BLOOM:
+    return "bloom";
+  case MITM_FILTER_BITMAP:
+    return "bitmap";
+  default:
+    return "unknown";
+  }
+}
+
+void mitm_get_config(MitmConfig *config) {
+  if (config)
+    *config = g_config;
+}
+
+void mitm_configure(const MitmConfig *config) {
+  if (config)
+    g_config = *config;
+}
+
+// ============== 后台预热 ==============
+// mitm_init_async 在独立线程上执行 init_table，调用方继续网络 I/O；
+// mitm_wait_ready 汇合 (join) 该线程，相当于等待一个 future。
+// 启动与汇合只在调用 mitm_init_async 的线程上进行 (mitm_init / cleanup)；
+// 查询可在任意线程上读取 g_warmup_started，预热期间不等待而改用无表模式
+static thread_t g_warmup_thread;
+static atomic_int g_warmup_started = 0;
+static int g_warmup_rc = -1;
+static char g_warmup_path[1024];
+
+static int init_table(const char *cache_path);
+
+#ifdef _WIN32
+static DWORD WINAPI warmup_main(void *arg) {
+#else
+static void *warmup_main(void *arg) {
+#endif
+  (void)arg;
+  g_warmup_rc = init_table(g_warmup_path);
+#ifdef _WIN32
+  return 0;
+#else
+  return NULL;
+#endif
+}
+
+int mitm_init_async(const char *cache_path) {
+  if (g_mitm_ready || g_warmup_started)
+    return 0;
+
+  snprintf(g_warmup_path, sizeof(g_warmup_path), "%s",
+           cache_path ? cache_path : DEFAULT_CACHE_PATH);
+  // 预热期间的查询与预热线程都会用到移位算子：先在本线程上算好
+  ensure_length_shifts();
+  if (THREAD_CREATE(&g_warmup_thread, warmup_main, NULL) != 0) {
+    fprintf(stderr, "[MITM] Failed to start background warm-up\n");
+    return -1;
+  }
+  g_warmup_started = 1;
+  printf("[MITM] Warming up lookup table in the background...\n");
+  return 0;
+}
+
+int mitm_cache_valid(const char *cache_path) {
+  FILE *f = fopen(cache_path ? cache_path : DEFAULT_CACHE_PATH, "rb");
+  if (!f)
+    return 0;
+
+  // 只比较文件头与当前配置的布局，不打印重建原因
+  TableHeader header, expect;
+  table_layout(&expect);
+  fseek(f, 0, SEEK_END);
+  long file_size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  int valid = file_size >= (long)sizeof(header) &&
+              fread(&header, sizeof(header), 1, f) == 1 &&
+              memcmp(&header, &expect, sizeof(expect)) == 0 &&
+              (uint64_t)file_size >= header.file_size;
+  fclose(f);
+  return valid;
+}
+
+int mitm_wait_ready(void) {
+  if (!g_warmup_started)
+    return g_mitm_ready ? 0 : -1;
+
+  if (!g_mitm_ready)
+    printf("[MITM] Waiting for background warm-up to finish...\n");
+  THREAD_JOIN(g_warmup_thread);
+  g_warmup_started = 0;
+  return g_warmup_rc;
+}
+
+int mitm_init(const char *cache_path) {
+  // 已在后台预热时等待其完成，不重复加载
+  if (g_warmup_started)
+    return mitm_wait_ready();
+  if (g_mitm_ready)
+    return 0;
+  return init_table(cache_path ? cache_path : DEFAULT_CACHE_PATH);
+}
+
+// 加载或构建表 (同步执行；后台预热时运行在预热线程上)
+static int init_table(const char *cache_path) {
+  // 初始化 CRC32 扩展查找表 (基础表已在 crc32_core.h 中静态初始化)
+  crc32_init();
+
+  // 尝试从缓存加载：优先只读映射，无法映射时退回整表读入
+  // 请求大页时读入私有的大页内存 (以放弃多进程共享换取 TLB 覆盖范围)
+  int share = g_config.use_mmap && !g_config.huge_pages;
+  int mapped = share ? map_table(cache_path) : -1;
+  if (mapped == 0 || (mapped == -1 && load_table(cache_path) == 0)) {
+    // 即使从缓存加载，也必须进行预计算
+    ensure_length_shifts();
+    report_backing();
+    g_mitm_ready = 1;
+    return 0;
+  }
+
+  // 缓存不存在，构建表
+  if (build_image() != 0) {
+    free_table();
+    return -1;
+  }
+
+  // 保存缓存；启用映射时改用映射副本，让后续进程共享同一份页缓存
+  if (save_table(cache_path) == 0 && share) {
+    uint8_t *heap_image = g_image;
+    size_t heap_size = g_alloc_size;
+    MitmBacking heap_backing = g_backing;
+    if (map_table(cache_path) == 0) {
+      release_image(heap_image, heap_size, heap_backing);
+    }
+    // 映射失败时 attach_image 未执行，仍使用堆副本
+  }
+
+  // 预计算各长度的位移矩阵 (Critical for performance)
+  ensure_length_shifts();
+  report_backing();
+
+  g_mitm_ready = 1;
+  return 0;
+}
+
+// ============== 智能 UID 过滤器 ==============
+// 基于真实用户数据的白名单 (数据来源: B站热门视频评论区)
+// 采集 457 用户，筛选出 71 个 16 位 UID，分析前缀分布
+
+// 16位 Snowflake UID - 基于实测数据的前缀白名单 (5位粒度，升序)
+// 数据来源: B站热门视频评论区 (445样本, 68有效)
+static const uint32_t g_uid_prefixes[] = {
+    34615, 34930, 34931, 34932, 34943, 35371, 35463,
+    35465, 35466, 35467, 35468, 35469, 36323, 36909,
+};
+#define UID_PREFIX_COUNT                                                       \
+  ((int)(sizeof(g_uid_prefixes) / sizeof(g_uid_prefixes[0])))
+
+static int is_whitelisted_prefix(uint32_t prefix) {
+  for (int i = 0; i < UID_PREFIX_COUNT; i++) {
+    if (g_uid_prefixes[i] == prefix)
+      return 1;
+  }
+  return 0;
+}
+
+static int is_likely_valid_uid(uint64_t uid) {
+  // 1. Legacy UID (0 ~ 2.2B)
+  if (uid > 0 && uid <= LEGACY_UID_MAX) {
+    return 1;
+  }
+
+  // 2. 16位 Snowflake UID：取前5位查白名单
+  if (uid >= 1000000000000000ULL && uid < 10000000000000000ULL) {
+    return is_whitelisted_prefix((uint32_t)(uid / 100000000000ULL));
+  }
+
+  // 3. 其他区间为噪音
+  return 0;
+}
+
+// 高位区间 [begin, end)
+typedef struct {
+  uint32_t begin;
+  uint32_t end;
+} HighRange;
+
+#define MAX_HIGH_RANGES (UID_PREFIX_COUNT + 1)
+
+// 把白名单换算成需要遍历的高位区间 (升序)，其余 h 组合出的 UID 必被过滤
+// 旧版 9-10 位 UID: h = uid / 10^8 ∈ [1, 22]
+// 16 位 UID: 前缀 P 对应 h ∈ [P * 1000, P * 1000 + 1000)
+static int build_high_ranges(HighRange *ranges) {
+  int count = 0;
+  ranges[count].begin = 1;
+  ranges[count].end = (uint32_t)(LEGACY_UID_MAX / LOW_PART_LIMIT) + 1;
+  count++;
+
+  for (int i = 0; i < UID_PREFIX_COUNT; i++) {
+    ranges[count].begin = g_uid_prefixes[i] * PREFIX_SPAN;
+    ranges[count].end = ranges[count].begin + PREFIX_SPAN;
+    count++;
+  }
+  return count;
+}
+
+// ============== 并行查询 ==============
+
+// 无表模式的所需 CRC(L) 集合 (开放寻址，线性探测)
+// 键为所需 CRC(L)，值为高位 h；短 UID 的查表键也放入集合，值为 STREAM_SHORT | n
+#define STREAM_EMPTY 0xFFFFFFFFu
+#define STREAM_SHORT 0x80000000u
+typedef struct {
+  uint32_t key;
+  uint32_t value;
+} StreamSlot;
+
+// 归并模式的 (所需 CRC(L), 高位) 对，value 编码与 StreamSlot 相同
+typedef struct {
+  uint32_t key;
+  uint32_t value;
+} JoinPair;
+
+// 前置位图：CRC 高 18 位 (32 KB，常驻 L1)，绝大多数低位无需访问哈希集合
+#define STREAM_FILTER_BITS 18
+
+typedef struct {
+  StreamSlot *slots;
+  uint32_t mask; // 槽数 - 1 (槽数为 2 的幂)
+  uint64_t filter[(1u << STREAM_FILTER_BITS) / 64];
+} StreamSet;
+
+// 流式输出：各任务验证通过的候选先进入队列，由一个投递线程在锁外串行交给回调
+// 回调返回非 0 后置位 stop，其余任务在下一个检查点退出
+typedef struct {
+  MitmCandidateFn fn;
+  void *user;
+  mutex_t lock; // 只保护下列队列状态，回调执行期间不持有
+  atomic_int stop;
+  int draining;       // 是否已有线程在投递 (同一时刻至多一个)
+  uint64_t *queue;    // 待投递候选 [head, tail)
+  int head;
+  int tail;
+  int queue_capacity;
+  int count; // 已交给回调的候选数
+} MitmSink;
+
+// 单个查询任务 (线程池任务上下文)：一段区间 [begin, end)
+// 查表模式下为高位区间，无表模式下为低位区间
+typedef struct {
+  MitmSink *sink; // 单目标查询的结果出口 (批量模式为 NULL，结果留在 uids)
+  uint32_t target;
+  uint32_t begin;
+  uint32_t end;
+  const StreamSet *set; // 无表模式使用
+  const JoinPair *pairs; // 归并模式使用 (按键升序)
+  const uint32_t *targets; // 批量模式使用：全部目标 (此时忽略 target)
+  uint32_t target_count;
+  uint64_t pending[VERIFY_BATCH]; // 待批量验证的候选
+  uint32_t pending_tag[VERIFY_BATCH]; // 候选所属目标下标 (批量模式)
+  int pending_count;
+  uint64_t *uids; // 本任务验证通过的 UID (按需扩容)
+  uint32_t *tags; // 与 uids 一一对应的目标下标 (仅批量模式分配)
+  int count;
+  int capacity;
+  int failed; // 内存不足
+} MitmTask;
+
+// n 位数字的取值下界 / 上界 (n = 1 时下界取 0)
+static const uint32_t g_pow10_u32[LOW_PART_DIGITS + 1] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000};
+
+static void sink_init(MitmSink *sink, MitmCandidateFn fn, void *user) {
+  memset(sink, 0, sizeof(*sink));
+  sink->fn = fn;
+  sink->user = user;
+  MUTEX_INIT(&sink->lock);
+  atomic_init(&sink->stop, 0);
+}
+
+static void sink_destroy(MitmSink *sink) {
+  MUTEX_DESTROY(&sink->lock);
+  free(sink->queue);
+}
+
+// 交出一批候选 (已停止时丢弃)
+// 候选按发现顺序入队；若无线程在投递，当前线程成为投递者，
+// 在锁外逐个调用回调直到队列取空。其他线程只入队，不等待回调
+static void sink_emit(MitmSink *sink, const uint64_t *uids, int n) {
+  MUTEX_LOCK(&sink->lock);
+  if (atomic_load(&sink->stop)) {
+    MUTEX_UNLOCK(&sink->lock);
+    return;
+  }
+
+  if (sink->tail + n > sink->queue_capacity) {
+    int new_capacity = sink->queue_capacity ? sink->queue_capacity : 256;
+    while (new_capacity < sink->tail + n)
+      new_capacity *= 2;
+    uint64_t *grown = (uint64_t *)realloc(
+        sink->queue, sizeof(uint64_t) * (size_t)new_capacity);
+    if (!grown) {
+      fprintf(stderr, "[MITM] Failed to queue candidates, stopping\n");
+      atomic_store(&sink->stop, 1);
+      MUTEX_UNLOCK(&sink->lock);
+      return;
+    }
+    sink->queue = grown;
+    sink->queue_capacity = new_capacity;
+  }
+  memcpy(sink->queue + sink->tail, uids, sizeof(uint64_t) * (size_t)n);
+  sink->tail += n;
+  if (sink->draining) {
+    MUTEX_UNLOCK(&sink->lock);
+    return;
+  }
+
+  sink->draining = 1;
+  uint64_t local[VERIFY_BATCH];
+  while (sink->head < sink->tail && !atomic_load(&sink->stop)) {
+    int take = sink->tail - sink->head;
+    if (take > VERIFY_BATCH)
+      take = VERIFY_BATCH;
+    memcpy(local, sink->queue + sink->head, sizeof(uint64_t) * (size_t)take);
+    sink->head += take;
+    if (sink->head == sink->tail)
+      sink->head = sink->tail = 0;
+    MUTEX_UNLOCK(&sink->lock);
+
+    int delivered = 0;
+    while (delivered < take) {
+      if (sink->fn(local[delivered++], sink->user) != 0) {
+        atomic_store(&sink->stop, 1);
+        break;
+      }
+    }
+
+    MUTEX_LOCK(&sink->lock);
+    sink->count += delivered;
+  }
+  if (atomic_load(&sink->stop))
+    sink->head = sink->tail = 0;
+  sink->draining = 0;
+  MUTEX_UNLOCK(&sink->lock);
+}
+
+// 消费者是否已要求停止 (工作线程在检查点轮询)
+static inline int task_stopped(const MitmTask *task) {
+  return task->sink &&
+         atomic_load_explicit(&task->sink->stop, memory_order_relaxed);
+}
+
+// 批量验证候选 CRC，通过者整批交给 sink，或按原顺序追加到任务缓冲区
+static void verify_pending(MitmTask *task) {
+  uint32_t crcs[VERIFY_BATCH];
+  uint64_t verified[VERIFY_BATCH];
+  int verified_count = 0;
+  crc32_digits_eval_batch(task->pending, (size_t)task->pending_count, crcs);
+
+  for (int i = 0; i < task->pending_count; i++) {
+    uint32_t tag = task->pending_tag[i];
+    uint32_t want = task->targets ? task->targets[tag] : task->target;
+    if (crcs[i] != want)
+      continue;
+    if (task->sink) {
+      verified[verified_count++] = task->pending[i];
+      continue;
+    }
+
+    if (task->count == task->capacity) {
+      int new_capacity = task->capacity ? task->capacity * 2 : 64;
+      uint64_t *grown = (uint64_t *)realloc(
+          task->uids, sizeof(uint64_t) * (size_t)new_capacity);
+      if (!grown) {
+        task->failed = 1;
+        break;
+      }
+      task->uids = grown;
+      if (task->targets) {
+        uint32_t *grown_tags = (uint32_t *)realloc(
+            task->tags, sizeof(uint32_t) * (size_t)new_capacity);
+        if (!grown_tags) {
+          task->failed = 1;
+          break;
+        }
+        task->tags = grown_tags;
+      }
+      task->capacity = new_capacity;
+    }
+    if (task->targets)
+      task->tags[task->count] = tag;
+    task->uids[task->count++] = task->pending[i];
+  }
+  task->pending_count = 0;
+  if (verified_count > 0)
+    sink_emit(task->sink, verified, verified_count);
+}
+
+// 流式输出时在检查点提前验证已攒下的候选，不等攒满一批
+static inline void flush_to_sink(MitmTask *task) {
+  if (task->sink && task->pending_count > 0)
+    verify_pending(task);
+}
+
+// 候选入队 (tag 为所属目标下标)，攒满一批即验证
+static inline void push_tagged(MitmTask *task, uint64_t uid, uint32_t tag) {
+  task->pending_tag[task->pending_count] = tag;
+  task->pending[task->pending_count++] = uid;
+  if (task->pending_count == VERIFY_BATCH)
+    verify_pending(task);
+}
+
+static inline void push_pending(MitmTask *task, uint64_t uid) {
+  push_tagged(task, uid, 0);
+}
+
+// 短 UID (1-8 位)：表键是补零到 8 位的串 Z || s (Z 为 8-n 个 '0')
+// CRC(Z || s) = Shift_n(CRC(Z)) ^ CRC(s)，每个长度只需查表一次，
+// 再按数值区间 [10^(n-1), 10^n) 确认 s 恰为 n 位 (批量模式下对每个目标各查一遍)
+static void scan_short_uids(MitmTask *task) {
+  uint32_t target_count = task->targets ? task->target_count : 1;
+  for (uint32_t t = 0; t < target_count; t++) {
+    uint32_t target = task->targets ? task->targets[t] : task->target;
+    for (int n = 1; n <= LOW_PART_DIGITS; n++) {
+      uint32_t len_lo = n > 1 ? g_pow10_u32[n - 1] : 0;
+      uint32_t low_candidates[16];
+      int candidate_count =
+          find_candidates(target ^ g_pad_key[n], low_candidates, 16);
+
+      for (int i = 0; i < candidate_count; i++) {
+        uint32_t low = low_candidates[i];
+        if (low < len_lo || low >= g_pow10_u32[n] || !is_likely_valid_uid(low))
+          continue;
+        push_tagged(task, low, t);
+      }
+    }
+  }
+  verify_pending(task);
+}
+
+// 长 UID (9-16 位)：遍历本任务的高位区间 (高位不含前导零，从 1 开始)
+static void mitm_task_worker(void *arg) {
+  MitmTask *task = (MitmTask *)arg;
+
+  if (task->begin >= task->end || task_stopped(task))
+    return;
+
+  // 所需 CRC(L) = Target ^ Shift(CRC(h))：区间起点全量计算一次，之后增量推进
+  HighEnum e;
+  high_enum_init(&e, task->target, task->begin);
+
+  // 攒满一批所需 CRC(L) 后整批探测 (处理 CRC 碰撞，每个键最多 16 个命中)
+  uint32_t keys[PROBE_BATCH_MAX];
+  ProbeHit hits[PROBE_BATCH_MAX * 16];
+  uint32_t first = task->begin; // 本批第一个键对应的高位
+  int batch = g_probe_batch;
+  int n = 0;
+
+  for (uint32_t h = task->begin; h < task->end; h++) {
+    if (h != task->begin)
+      high_enum_next(&e);
+    keys[n++] = e.required;
+    if (n < batch && h + 1 < task->end)
+      continue;
+
+    int hit_count = probe_batch(keys, n, hits);
+    for (int i = 0; i < hit_count; i++) {
+      // 组合完整 UID
+      uint64_t uid =
+          (uint64_t)(first + hits[i].index) * 100000000ULL + hits[i].low;
+
+      // 智能过滤：仅保留可能的有效 UID
+      if (is_likely_valid_uid(uid))
+        push_pending(task, uid);
+    }
+    flush_to_sink(task);
+    first = h + 1;
+    n = 0;
+    if (task_stopped(task))
+      break;
+  }
+  verify_pending(task);
+}
+
+// 批量查询：Shift(CRC(h)) 与目标无关，每个 h 只推进一次，
+// 再与各目标异或得到所需 CRC(L) 分别探测 (多一个目标只多一次探测)
+static void mitm_batch_worker(void *arg) {
+  MitmTask *task = (MitmTask *)arg;
+
+  if (task->begin >= task->end)
+    return;
+
+  // 以目标 0 枚举，e.required 即 Shift(CRC(h))
+  HighEnum e;
+  high_enum_init(&e, 0, task->begin);
+
+  // (高位, 目标) 组合攒满一批后整批探测
+  uint32_t keys[PROBE_BATCH_MAX];
+  uint32_t highs[PROBE_BATCH_MAX];
+  uint32_t tags[PROBE_BATCH_MAX];
+  ProbeHit hits[PROBE_BATCH_MAX * 16];
+  int batch = g_probe_batch;
+  int n = 0;
+
+  for (uint32_t h = task->begin; h < task->end; h++) {
+    if (h != task->begin)
+      high_enum_next(&e);
+
+    for (uint32_t t = 0; t < task->target_count; t++) {
+      keys[n] = e.required ^ task->targets[t];
+      highs[n] = h;
+      tags[n] = t;
+      n++;
+      if (n < batch && (h + 1 < task->end || t + 1 < task->target_count))
+        continue;
+
+      int hit_count = probe_batch(keys, n, hits);
+      for (int i = 0; i < hit_count; i++) {
+        uint32_t k = hits[i].index;
+        uint64_t uid = (uint64_t)highs[k] * 100000000ULL + hits[i].low;
+        if (is_likely_valid_uid(uid))
+          push_tagged(task, uid, tags[k]);
+      }
+      n = 0;
+    }
+  }
+  verify_pending(task);
+}
+
+// ============== 无表模式 ==============
+// 高位集合很小时，与其加载 540 MB 的表，不如把所需 CRC(L) 放进常驻缓存的
+// 小哈希集合，再流式枚举全部 10^8 个低位 (增量异或) 逐个探测
+
+static inline int stream_filter_test(const StreamSet *set, uint32_t key) {
+  uint32_t bit = key >> (32 - STREAM_FILTER_BITS);
+  return (int)((set->filter[bit >> 6] >> (bit & 63)) & 1);
+}
+
+static void stream_set_insert(StreamSet *set, uint32_t key, uint32_t value) {
+  uint32_t bit = key >> (32 - STREAM_FILTER_BITS);
+  set->filter[bit >> 6] |= 1ULL << (bit & 63);
+
+  uint32_t slot = key & set->mask;
+  while (set->slots[slot].value != STREAM_EMPTY)
+    slot = (slot + 1) & set->mask;
+  set->slots[slot].key = key;
+  set->slots[slot].value = value;
+}
+
+// 构建集合：白名单内全部高位 + 8 个短 UID 查表键
+static int stream_set_build(StreamSet *set, uint32_t target,
+                            const HighRange *ranges, int range_count,
+                            uint32_t high_count) {
+  // 负载因子不超过 1/4，探测链平均不到 1.2 个槽
+  uint32_t slots = 1024;
+  while (slots < (high_count + LOW_PART_DIGITS) * 4)
+    slots <<= 1;
+
+  set->slots = (StreamSlot *)malloc(sizeof(StreamSlot) * slots);
+  if (!set->slots)
+    return -1;
+  memset(set->slots, 0xFF, sizeof(StreamSlot) * slots);
+  set->mask = slots - 1;
+
+  for (int n = 1; n <= LOW_PART_DIGITS; n++) {
+    stream_set_insert(set, target ^ g_pad_key[n], STREAM_SHORT | (uint32_t)n);
+  }
+  for (int r = 0; r < range_count; r++) {
+    HighEnum e;
+    high_enum_init(&e, target, ranges[r].begin);
+    for (uint32_t h = ranges[r].begin; h < ranges[r].end; h++) {
+      if (h != ranges[r].begin)
+        high_enum_next(&e);
+      stream_set_insert(set, e.required, h);
+    }
+  }
+  return 0;
+}
+
+static void stream_set_free(StreamSet *set) {
+  if (set) {
+    free(set->slots);
+    free(set);
+  }
+}
+
+// 低位 low 的 CRC 命中某个所需键 (值编码见 StreamSlot)：还原出 UID 并入队
+static inline void emit_match(MitmTask *task, uint32_t value, uint32_t low) {
+  if (value & STREAM_SHORT) {
+    // 短 UID：补零串中去掉前导零后须恰为 n 位
+    int n = (int)(value & 0xFF);
+    uint32_t len_lo = n > 1 ? g_pow10_u32[n - 1] : 0;
+    if (low >= len_lo && low < g_pow10_u32[n] && is_likely_valid_uid(low))
+      push_pending(task, low);
+    return;
+  }
+
+  uint64_t uid = (uint64_t)value * 100000000ULL + low;
+  if (is_likely_valid_uid(uid))
+    push_pending(task, uid);
+}
+
+// 流式扫描本任务的低位区间：CRC(8 位补零串) 由里程表增量推进
+static void mitm_stream_worker(void *arg) {
+  MitmTask *task = (MitmTask *)arg;
+  const StreamSet *set = task->set;
+  const Crc32DigitTables *digits = crc32_digits_tables();
+
+  if (task->begin >= task->end || task_stopped(task))
+    return;
+
+  // 区间起点全量计算一次 CRC(L) = base[8] ^ XOR_j contrib[j][d_j]
+  uint8_t d[LOW_PART_DIGITS];
+  uint32_t crc = digits->base[LOW_PART_DIGITS];
+  uint32_t v = task->begin;
+  for (int j = 0; j < LOW_PART_DIGITS; j++) {
+    d[j] = (uint8_t)(v % 10);
+    crc ^= digits->contrib[j][d[j]];
+    v /= 10;
+  }
+
+  for (uint32_t low = task->begin; low < task->end; low++) {
+    if (low != task->begin) {
+      // 前进到 low + 1 (位数固定为 8，不会产生新的最高位)
+      int j = 0;
+      while (d[j] == 9) {
+        crc ^= g_low_step[j][9];
+        d[j++] = 0;
+      }
+      crc ^= g_low_step[j][d[j]];
+      d[j]++;
+      if ((low & 0xFFFF) == 0) {
+        flush_to_sink(task);
+        if (task_stopped(task))
+          break;
+      }
+    }
+
+    if (!stream_filter_test(set, crc))
+      continue;
+    for (uint32_t slot = crc & set->mask; set->slots[slot].value != STREAM_EMPTY;
+         slot = (slot + 1) & set->mask) {
+      if (set->slots[slot].key == crc)
+        emit_match(task, set->slots[slot].value, low);
+    }
+  }
+  verify_pending(task);
+}
+
+// ============== 归并模式 ==============
+// 高位集合很大时，逐个随机探测表会让每次查找都落在不同的缓存行与页上。
+// 归并模式先生成全部 (所需 CRC(L), h) 对并按键基数排序，再与按 CRC
+// 排列的表做一次归并连接：桶偏移、rem、low 三段都只向前单调访问
+
+// 生成全部键值对：8 个短 UID 查表键 + 白名单内全部高位
+static JoinPair *join_pairs_build(uint32_t target, const HighRange *ranges,
+                                  int range_count, uint32_t high_count,
+                                  uint32_t *pair_count) {
+  uint32_t n = high_count + LOW_PART_DIGITS;
+  JoinPair *pairs = (JoinPair *)malloc(sizeof(JoinPair) * n);
+  if (!pairs)
+    return NULL;
+
+  uint32_t k = 0;
+  for (int len = 1; len <= LOW_PART_DIGITS; len++) {
+    pairs[k].key = target ^ g_pad_key[len];
+    pairs[k++].value = STREAM_SHORT | (uint32_t)len;
+  }
+  for (int r = 0; r < range_count; r++) {
+    HighEnum e;
+    high_enum_init(&e, target, ranges[r].begin);
+    for (uint32_t h = ranges[r].begin; h < ranges[r].end; h++) {
+      if (h != ranges[r].begin)
+        high_enum_next(&e);
+      pairs[k].key = e.required;
+      pairs[k++].value = h;
+    }
+  }
+  *pair_count = k;
+  return pairs;
+}
+
+// LSD 基数排序 (按 32 位键，4 轮 8 位)，稳定；偶数轮后结果回到 pairs
+static int join_pairs_sort(JoinPair *pairs, uint32_t n) {
+  JoinPair *tmp = (JoinPair *)malloc(sizeof(JoinPair) * (n ? n : 1));
+  if (!tmp)
+    return -1;
+
+  JoinPair *src = pairs;
+  JoinPair *dst = tmp;
+  for (int shift = 0; shift < 32; shift += 8) {
+    uint32_t offset[256] = {0};
+    for (uint32_t i = 0; i < n; i++)
+      offset[(src[i].key >> shift) & 0xFF]++;
+    uint32_t sum = 0;
+    for (int d = 0; d < 256; d++) {
+      uint32_t size = offset[d];
+      offset[d] = sum;
+      sum += size;
+    }
+    for (uint32_t i = 0; i < n; i++)
+      dst[offset[(src[i].key >> shift) & 0xFF]++] = src[i];
+
+    JoinPair *swap = src;
+    src = dst;
+    dst = swap;
+  }
+
+  free(tmp);
+  return 0;
+}
+
+// 归并连接本任务的有序键区间 [begin, end)：键升序，桶号随之单调不减
+static void mitm_merge_worker(void *arg) {
+  MitmTask *task = (MitmTask *)arg;
+  const JoinPair *pairs = task->pairs;
+
+  for (uint32_t i = task->begin; i < task->end; i++) {
+    if ((i & 0xFFF) == 0) {
+      flush_to_sink(task);
+      if (task_stopped(task))
+        break;
+    }
+    uint32_t key = pairs[i].key;
+    uint32_t bucket = key >> MITM_REM_BITS;
+    uint8_t rem = (uint8_t)key;
+    uint32_t end = g_bucket[bucket + 1];
+
+    for (uint32_t k = g_bucket[bucket]; k < end; k++) {
+      if (g_rem[k] == rem)
+        emit_match(task, pairs[i].value, g_low[k]);
+    }
+  }
+  verify_pending(task);
+}
+
+// ============== 查询入口 ==============
+
+static int uid_compare(const void *a, const void *b) {
+  uint64_t ua = *(const uint64_t *)a;
+  uint64_t ub = *(const uint64_t *)b;
+  return (ua > ub) - (ua < ub);
+}
+
+void mitm_select_plan(MitmPlan plan) { g_plan = plan; }
+
+const char *mitm_plan_name(MitmPlan plan) {
+  switch (plan) {
+  case MITM_PLAN_AUTO:
+    return "auto";
+  case MITM_PLAN_TABLE:
+    return "table-probe";
+  case MITM_PLAN_STREAM:
+    return "table-free";
+  case MITM_PLAN_MERGE:
+    return "merge-join";
+  default:
+    return "unknown";
+  }
+}
+
+// 按高位集合规模与表是否就绪选择查询策略 (后台预热未完成视为未就绪)
+// 表已加载时总是逐个探测：批量预取流水线下，即使无过滤器，从 1K 到 4M 个
+// 高位查表都快于归并 (单核实测 4M 高位 225 ms 对 331 ms)，因此归并只在
+// mitm_select_plan 显式指定时使用，作为 -bench 的对照策略；
+// 表未加载且高位集合足够小时，流式扫描 10^8 个低位比加载 540 MB 表更省时
+static MitmPlan choose_plan(uint32_t high_count) {
+  if (g_plan != MITM_PLAN_AUTO)
+    return g_plan;
+  if (g_mitm_ready)
+    return MITM_PLAN_TABLE;
+  return high_count <= STREAM_MAX_HIGH ? MITM_PLAN_STREAM : MITM_PLAN_TABLE;
+}
+
+// 按指定策略执行一次搜索，候选验证后立即交给 sink (不打印候选)
+// 候选按发现顺序交出，不保证有序；查表与归并策略要求表已加载
+static int run_search(uint32_t target, MitmPlan plan, const HighRange *ranges,
+                      int range_count, uint32_t high_count, MitmSink *sink) {
+  // 任务 0 处理短 UID (仅查表模式)，其余任务为高位、低位或有序键区间
+  StreamSet *set = NULL; // 含 32 KB 位图，放在堆上
+  JoinPair *pairs = NULL;
+  uint32_t pair_count = 0;
+  int task_count = 0;
+  if (plan == MITM_PLAN_STREAM) {
+    set = (StreamSet *)calloc(1, sizeof(StreamSet));
+    if (!set ||
+        stream_set_build(set, target, ranges, range_count, high_count) != 0) {
+      fprintf(stderr, "[MITM] Failed to allocate stream set\n");
+      stream_set_free(set);
+      return -1;
+    }
+    task_count = (LOW_PART_LIMIT + STREAM_TASK_SPAN - 1) / STREAM_TASK_SPAN;
+  } else if (plan == MITM_PLAN_MERGE) {
+    pairs = join_pairs_build(target, ranges, range_count, high_count,
+                             &pair_count);
+    if (!pairs || join_pairs_sort(pairs, pair_count) != 0) {
+      fprintf(stderr, "[MITM] Failed to allocate join pairs\n");
+      free(pairs);
+      return -1;
+    }
+    task_count = (int)((pair_count + MERGE_TASK_PAIRS - 1) / MERGE_TASK_PAIRS);
+  } else {
+    for (int r = 0; r < range_count; r++) {
+      uint32_t len = ranges[r].end - ranges[r].begin;
+      task_count += (int)((len + MITM_TASK_SPAN - 1) / MITM_TASK_SPAN);
+    }
+  }
+
+  MitmTask *tasks = (MitmTask *)calloc((size_t)task_count + 1, sizeof(MitmTask));
+  if (!tasks) {
+    fprintf(stderr, "[MITM] Failed to allocate task contexts\n");
+    stream_set_free(set);
+    free(pairs);
+    return -1;
+  }
+  for (int t = 0; t <= task_count; t++) {
+    tasks[t].sink = sink;
+    tasks[t].target = target;
+    tasks[t].set = set;
+    tasks[t].pairs = pairs;
+  }
+
+  int rc;
+  if (plan == MITM_PLAN_STREAM) {
+    for (int t = 1; t <= task_count; t++) {
+      uint32_t begin = (uint32_t)(t - 1) * STREAM_TASK_SPAN;
+      uint32_t end = begin + STREAM_TASK_SPAN;
+      tasks[t].begin = begin;
+      tasks[t].end = end < LOW_PART_LIMIT ? end : LOW_PART_LIMIT;
+    }
+
+    // 短 UID 的查表键已在集合中，随低位流一并命中
+    rc = thread_pool_run(mitm_stream_worker, tasks + 1, sizeof(MitmTask),
+                         task_count);
+  } else if (plan == MITM_PLAN_MERGE) {
+    for (int t = 1; t <= task_count; t++) {
+      uint32_t begin = (uint32_t)(t - 1) * MERGE_TASK_PAIRS;
+      tasks[t].begin = begin;
+      tasks[t].end = pair_count - begin > MERGE_TASK_PAIRS
+                         ? begin + MERGE_TASK_PAIRS
+                         : pair_count;
+    }
+
+    // 短 UID 的查表键与高位键一起排序，随归并一并命中
+    rc = thread_pool_run(mitm_merge_worker, tasks + 1, sizeof(MitmTask),
+                         task_count);
+  } else {
+    int t = 1;
+    for (int r = 0; r < range_count; r++) {
+      for (uint32_t begin = ranges[r].begin; begin < ranges[r].end;
+           begin += MITM_TASK_SPAN) {
+        uint32_t end = ranges[r].end - begin > MITM_TASK_SPAN
+                           ? begin + MITM_TASK_SPAN
+                           : ranges[r].end;
+        tasks[t].begin = begin;
+        tasks[t].end = end;
+        t++;
+      }
+    }
+
+    // MITM 攻击核心逻辑：短 UID 只需 8 次查表，在调用线程完成；
+    // 高位区间交给常驻线程池并行遍历
+    scan_short_uids(&tasks[0]);
+    rc = thread_pool_run(mitm_task_worker, tasks + 1, sizeof(MitmTask),
+                         task_count);
+  }
+  if (rc != 0)
+    fprintf(stderr, "[MITM] Failed to dispatch search tasks\n");
+
+  free(tasks);
+  stream_set_free(set);
+  free(pairs);
+  return rc;
+}
+
+// 收集候选到 MitmResult 的回调：缓冲区已满时要求停止
+typedef struct {
+  MitmResult *result;
+  int full;
+} MitmCollect;
+
+static int collect_candidate(uint64_t uid, void *user) {
+  MitmCollect *collect = (MitmCollect *)user;
+  MitmResult *result = collect->result;
+  if (result->count == result->capacity) {
+    collect->full = 1;
+    return 1;
+  }
+  result->uids[result->count++] = uid;
+  return 0;
+}
+
+// 收集结束：提示缓冲区已满，并把候选按 UID 升序排列
+// (各任务并行交出候选，顺序不确定)
+static void collect_finish(const MitmCollect *collect) {
+  MitmResult *result = collect->result;
+  if (collect->full)
+    printf("[MITM] Warning: Result buffer full (%d), search stopped early\n",
+           result->capacity);
+  qsort(result->uids, (size_t)result->count, sizeof(uint64_t), uid_compare);
+}
+
+// 执行一次搜索并把候选按 UID 升序收集到 result
+static int search_collect(uint32_t target, MitmPlan plan,
+                          const HighRange *ranges, int range_count,
+                          uint32_t high_count, MitmResult *result) {
+  MitmCollect collect = {result, 0};
+  MitmSink sink;
+  sink_init(&sink, collect_candidate, &collect);
+
+  result->count = 0;
+  int rc = run_search(target, plan, ranges, range_count, high_count, &sink);
+  sink_destroy(&sink);
+  collect_finish(&collect);
+  return rc;
+}
+
+// 结果数组未分配时按默认容量分配
+static int ensure_result_buffer(MitmResult *result) {
+  if (result->uids == NULL) {
+    result->capacity = MAX_MITM_RESULTS;
+    result->uids = (uint64_t *)malloc(sizeof(uint64_t) * result->capacity);
+    if (result->uids == NULL) {
+      fprintf(stderr, "[MITM] Failed to allocate result buffer\n");
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// 单目标查询的公共部分：解析哈希、选择策略、打印策略并执行搜索
+// 候选全部交给 sink，*plan_used 返回实际使用的策略
+static int crack_with_sink(const char *target_hash, MitmSink *sink,
+                           MitmPlan *plan_used) {
+  // 解析目标哈希
+  uint32_t target = (uint32_t)strtoul(target_hash, NULL, 16);
+  printf("[MITM] Target hash: %08x\n", target);
+
+  ensure_length_shifts();
+
+  // 只遍历白名单对应的高位区间 (约 1.4 万个 h，而非 10^8)
+  HighRange ranges[MAX_HIGH_RANGES];
+  int range_count = build_high_ranges(ranges);
+  uint32_t high_count = 0;
+  for (int r = 0; r < range_count; r++) {
+    high_count += ranges[r].end - ranges[r].begin;
+  }
+
+  MitmPlan plan = choose_plan(high_count);
+  *plan_used = plan;
+  if (plan != MITM_PLAN_STREAM && !g_mitm_ready) {
+    fprintf(stderr, "[MITM] Lookup table not loaded (call mitm_init)\n");
+    return -1;
+  }
+
+  if (plan == MITM_PLAN_STREAM) {
+    if (g_warmup_started && !g_mitm_ready)
+      printf("[MITM] Table still warming up, not waiting for it\n");
+    printf("[MITM] Table-free scan: %u high parts, streaming %d low parts\n",
+           high_count, LOW_PART_LIMIT);
+  } else if (plan == MITM_PLAN_MERGE) {
+    printf("[MITM] Merge-joining %u sorted high parts against the table\n",
+           high_count);
+  } else {
+    printf("[MITM] Enumerating %u high parts in %d whitelist ranges\n",
+           high_count, range_count);
+  }
+
+  return run_search(target, plan, ranges, range_count, high_count, sink) != 0
+             ? -1
+             : 0;
+}
+
+int mitm_crack_stream(const char *target_hash, MitmCandidateFn fn,
+                      void *user) {
+  if (!target_hash || !fn)
+    return -1;
+
+  double start = wall_seconds();
+  MitmSink sink;
+  sink_init(&sink, fn, user);
+
+  MitmPlan plan;
+  int rc = crack_with_sink(target_hash, &sink, &plan);
+  sink_destroy(&sink);
+  if (rc != 0)
+    return -1;
+
+  printf("[MITM] Search %s (%s), delivered %d candidates, took %.2f "
+         "seconds\n",
+         atomic_load(&sink.stop) ? "stopped early" : "complete",
+         mitm_plan_name(plan), sink.count, wall_seconds() - start);
+  return sink.count;
+}
+
+int mitm_crack(const char *target_hash, MitmResult *result) {
+  if (!result)
+    return -1;
+
+  result->count = 0;
+
+  // 动态分配结果数组（如果未分配）
+  if (ensure_result_buffer(result) != 0)
+    return -1;
+
+  double start = wall_seconds();
+  MitmCollect collect = {result, 0};
+  MitmSink sink;
+  sink_init(&sink, collect_candidate, &collect);
+
+  MitmPlan plan;
+  int rc = crack_with_sink(target_hash, &sink, &plan);
+  sink_destroy(&sink);
+  if (rc != 0)
+    return -1;
+  collect_finish(&collect);
+
+  // 仅打印前 100 个结果
+  for (int i = 0; i < result->count && i < 100; i++) {
+    printf("[MITM] Found candidate: %I64u\n", result->uids[i]);
+  }
+  if (result->count > 100) {
+    printf("[MITM] ... more results suppressed ...\n");
+  }
+
+  double elapsed = wall_seconds() - start;
+  printf("[MITM] Search complete (%s), found %d candidates, took %.2f "
+         "seconds\n",
+         mitm_plan_name(plan), result->count, elapsed);
+
+  return result->count;
+}
+
+static int match_compare(const void *a, const void *b) {
+  const MitmMatch *ma = (const MitmMatch *)a;
+  const MitmMatch *mb = (const MitmMatch *)b;
+  if (ma->target_index != mb->target_index)
+    return (ma->target_index > mb->target_index) -
+           (ma->target_index < mb->target_index);
+  return (ma->uid > mb->uid) - (ma->uid < mb->uid);
+}
+
+// 追加一条批量结果 (按需扩容)，返回 0=成功
+static int append_match(MitmBatchResult *result, uint64_t uid,
+                        uint32_t target_index) {
+  if (result->count == result->capacity) {
+    int new_capacity = result->capacity ? result->capacity * 2 : 256;
+    MitmMatch *grown = (MitmMatch *)realloc(
+        result->matches, sizeof(MitmMatch) * (size_t)new_capacity);
+    if (!grown)
+      return -1;
+    result->matches = grown;
+    result->capacity = new_capacity;
+  }
+  result->matches[result->count].uid = uid;
+  result->matches[result->count].target_index = target_index;
+  result->count++;
+  return 0;
+}
+
+// 表未加载时的批量查询：各目标分别做一次无表扫描
+static int crack_batch_stream(const uint32_t *targets, size_t n,
+                              const HighRange *ranges, int range_count,
+                              uint32_t high_count, MitmBatchResult *result) {
+  MitmResult single = {0};
+  if (ensure_result_buffer(&single) != 0)
+    return -1;
+
+  int rc = 0;
+  for (size_t t = 0; t < n && rc == 0; t++) {
+    rc = search_collect(targets[t], MITM_PLAN_STREAM, ranges, range_count,
+                        high_count, &single);
+    for (int i = 0; i < single.count && rc == 0; i++) {
+      if (append_match(result, single.uids[i], (uint32_t)t) != 0)
+        rc = -1;
+    }
+  }
+  free(single.uids);
+  return rc;
+}
+
+int mitm_crack_batch(const uint32_t *targets, size_t n,
+                     MitmBatchResult *result) {
+  if (!result || (!targets && n > 0))
+    return -1;
+
+  result->count = 0;
+  if (n == 0)
+    return 0;
+
+  double start = wall_seconds();
+  ensure_length_shifts();
+
+  HighRange ranges[MAX_HIGH_RANGES];
+  int range_count = build_high_ranges(ranges);
+  uint32_t high_count = 0;
+  for (int r = 0; r < range_count; r++) {
+    high_count += ranges[r].end - ranges[r].begin;
+  }
+
+  int rc;
+  if (!g_mitm_ready) {
+    printf("[MITM] Batch of %zu targets: table %s, scanning each "
+           "table-free\n",
+           n, g_warmup_started ? "still warming up" : "not loaded");
+    rc = crack_batch_stream(targets, n, ranges, range_count, high_count,
+                            result);
+  } else {
+    printf("[MITM] Batch of %zu targets: enumerating %u high parts once\n", n,
+           high_count);
+
+    int task_count = 0;
+    for (int r = 0; r < range_count; r++) {
+      uint32_t len = ranges[r].end - ranges[r].begin;
+      task_count += (int)((len + MITM_TASK_SPAN - 1) / MITM_TASK_SPAN);
+    }
+
+    MitmTask *tasks =
+        (MitmTask *)calloc((size_t)task_count + 1, sizeof(MitmTask));
+    if (!tasks) {
+      fprintf(stderr, "[MITM] Failed to allocate task contexts\n");
+      return -1;
+    }
+    int t = 1;
+    for (int r = 0; r < range_count; r++) {
+      for (uint32_t begin = ranges[r].begin; begin < ranges[r].end;
+           begin += MITM_TASK_SPAN) {
+        uint32_t end = ranges[r].end - begin > MITM_TASK_SPAN
+                           ? begin + MITM_TASK_SPAN
+                           : ranges[r].end;
+        tasks[t].begin = begin;
+        tasks[t].end = end;
+        t++;
+      }
+    }
+    for (t = 0; t <= task_count; t++) {
+      tasks[t].targets = targets;
+      tasks[t].target_count = (uint32_t)n;
+    }
+
+    // 短 UID 在调用线程完成，高位区间交给线程池
+    scan_short_uids(&tasks[0]);
+    rc = thread_pool_run(mitm_batch_worker, tasks + 1, sizeof(MitmTask),
+                         task_count);
+    if (rc != 0)
+      fprintf(stderr, "[MITM] Failed to dispatch search tasks\n");
+
+    for (t = 0; t <= task_count; t++) {
+      MitmTask *task = &tasks[t];
+      if (task->failed)
+        fprintf(stderr, "[MITM] Warning: task %d ran out of memory\n", t);
+      for (int i = 0; i < task->count && rc == 0; i++) {
+        if (append_match(result, task->uids[i], task->tags[i]) != 0) {
+          fprintf(stderr, "[MITM] Failed to grow batch result\n");
+          rc = -1;
+        }
+      }
+      free(task->uids);
+      free(task->tags);
+    }
+    free(tasks);
+  }
+
+  // 按 (目标下标, UID) 排序，同一目标的结果连续
+  qsort(result->matches, (size_t)result->count, sizeof(MitmMatch),
+        match_compare);
+
+  printf("[MITM] Batch complete, found %d candidates for %zu targets, took "
+         "%.2f seconds\n",
+         result->count, n, wall_seconds() - start);
+  return rc != 0 ? -1 : result->count;
+}
+
+// ============== 查询策略基准测试 ==============
+
+// 在一组高位集合上对比查表探测与归并连接，打印一行结果
+static void bench_plan_row(const char *name, const HighRange *ranges,
+                           int range_count, MitmResult *result) {
+  uint32_t high_count = 0;
+  for (int r = 0; r < range_count; r++) {
+    high_count += ranges[r].end - ranges[r].begin;
+  }
+
+  const MitmPlan plans[] = {MITM_PLAN_TABLE, MITM_PLAN_MERGE};
+  double ms[2];
+  int counts[2];
+  uint64_t digests[2]; // 候选集合摘要 (结果已按 UID 排序)
+
+  // 先不计时地跑一遍同一组目标，把要触及的表页面调入 (映射的表首次访问
+  // 会缺页)，两种策略在相同的页面状态下计时
+  uint32_t seed = 0x9E3779B9u;
+  for (int i = 0; i < BENCH_TARGETS; i++) {
+    seed = seed * 1103515245 + 12345;
+    search_collect(seed, MITM_PLAN_TABLE, ranges, range_count, high_count,
+                   result);
+  }
+
+  for (int p = 0; p < 2; p++) {
+    seed = 0x9E3779B9u; // 各策略使用同一组目标
+    double start = wall_seconds();
+    counts[p] = 0;
+    digests[p] = 0;
+    for (int i = 0; i < BENCH_TARGETS; i++) {
+      seed = seed * 1103515245 + 12345;
+      search_collect(seed, plans[p], ranges, range_count, high_count,
+                     result);
+      counts[p] += result->count;
+      for (int k = 0; k < result->count; k++)
+        digests[p] = digests[p] * 1000003 + result->uids[k];
+    }
+    ms[p] = (wall_seconds() - start) * 1000.0 / BENCH_TARGETS;
+  }
+
+  printf("  %-10s %10u %8d %12.2f %12.2f%s\n", name, high_count, counts[0],
+         ms[0], ms[1],
+         counts[0] == counts[1] && digests[0] == digests[1]
+             ? ""
+             : "  (结果不一致！)");
+}
+
+void mitm_benchmark(void) {
+  if (!g_mitm_ready && mitm_init(NULL) != 0) {
+    printf("[Bench] MITM 表加载失败，跳过查询策略对比\n");
+    return;
+  }
+  ensure_length_shifts();
+
+  MitmResult result = {0};
+  if (ensure_result_buffer(&result) != 0)
+    return;
+
+  printf("[Bench] MITM 查询策略 (每个目标平均耗时 ms，%d 个目标)\n",
+         BENCH_TARGETS);
+  printf("  %-10s %10s %8s %12s %12s\n", "highs", "count", "hits",
+         mitm_plan_name(MITM_PLAN_TABLE), mitm_plan_name(MITM_PLAN_MERGE));
+
+  // 稀疏：实际查询使用的白名单区间；稠密：连续的 8 位高位，
+  // 起点落在白名单前缀内，两种策略都能产出候选 (hits 为全部目标的候选总数)
+  HighRange ranges[MAX_HIGH_RANGES];
+  int range_count = build_high_ranges(ranges);
+  bench_plan_row("whitelist", ranges, range_count, &result);
+
+  HighRange dense = {BENCH_DENSE_BEGIN, BENCH_DENSE_BEGIN + BENCH_DENSE_HIGH};
+  bench_plan_row("dense", &dense, 1, &result);
+
+  // 探测流水线：同一稠密集合下按不同批大小逐个高位查表
+  // 批大小 1 即逐个同步探测 (每次探测等待一次内存延迟)
+  printf("[Bench] MITM 探测流水线 (%s 过滤器，稠密高位，百万次探测/秒)\n",
+         mitm_filter_name(g_filter_kind));
+  printf("  %-10s %12s %10s\n", "batch", "Mprobes/s", "speedup");
+  const int batches[] = {1, 8, PROBE_BATCH, PROBE_BATCH_MAX};
+  int saved_batch = g_probe_batch;
+  double base_rate = 0;
+  for (int b = 0; b < 4; b++) {
+    g_probe_batch = batches[b];
+    uint32_t seed = 0x9E3779B9u;
+    double start = wall_seconds();
+    for (int i = 0; i < BENCH_TARGETS; i++) {
+      seed = seed * 1103515245 + 12345;
+      search_collect(seed, MITM_PLAN_TABLE, &dense, 1, BENCH_DENSE_HIGH,
+                     &result);
+    }
+    double rate = (double)BENCH_DENSE_HIGH * BENCH_TARGETS /
+                  (wall_seconds() - start) / 1e6;
+    if (b == 0)
+      base_rate = rate;
+    printf("  %-10d %12.1f %9.2fx\n", batches[b], rate, rate / base_rate);
+  }
+  g_probe_batch = saved_batch;
+
+  free(result.uids);
+}
+
+void mitm_cleanup(void) {
+  if (g_warmup_started)
+    mitm_wait_ready();
+  free_table();
+  g_mitm_ready = 0;
+}
+
+int mitm_is_ready(void) { return g_mitm_ready; }
+
+size_t mitm_get_table_size_mb(void) { return TABLE_SIZE_BYTES / (1024 * 1024); }
+
+void mitm_get_stats(MitmStats *stats) {
+  if (!stats)
+    return;
+
+  memset(stats, 0, sizeof(*stats));
+  stats->backing = g_backing;
+  stats->table_bytes = g_image_size;
+  stats->huge_bytes = measure_huge_bytes();
+  stats->filter = g_filter_kind;
+  stats->filter_bytes = (size_t)filter_bytes(g_filter_kind);
+#ifdef _WIN32
+  stats->huge_page_size = GetLargePageMinimum();
+#else
+  stats->huge_page_size = HUGE_PAGE_SIZE;
+#endif
+  if (stats->huge_page_size)
+    stats->huge_pages = stats->huge_bytes / stats->huge_page_size;
+}
@@ -0,0 +1,245 @@
+/**
+ * thread_pool.c
+ * 常驻工作线程池实现
+ *
+ * 设计原则：
+ * 1. 线程只创建一次：工作线程在条件变量上休眠，等待下一批任务
+ * 2. 原子任务游标：工作线程通过 atomic_fetch_add 领取任务下标，天然负载均衡
+ * 3. 批次屏障：所有工作线程完成当前批次后才唤醒调用者
+ */
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#include "thread_pool.h"
+
+// ============== Windows / Pthreads 同步原语兼容层 ==============
+#ifdef _WIN32
+typedef HANDLE thread_t;
+typedef CRITICAL_SECTION mutex_t;
+typedef CONDITION_VARIABLE cond_t;
+#define THREAD_CREATE(t, func, arg)                                            \
+  (*(t) =                                                                      \
+       CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)(func), (arg), 0, NULL),  \
+   *(t) != NULL ? 0 : -1)
+#define THREAD_JOIN(t) (WaitForSingleObject(t, INFINITE), CloseHandle(t))
+#define MUTEX_INIT(m) InitializeCriticalSection(m)
+#define MUTEX_DESTROY(m) DeleteCriticalSection(m)
+#define MUTEX_LOCK(m) EnterCriticalSection(m)
+#define MUTEX_UNLOCK(m) LeaveCriticalSection(m)
+#define COND_INIT(c) InitializeConditionVariable(c)
+#define COND_DESTROY(c) ((void)0)
+#define COND_WAIT(c, m) SleepConditionVariableCS(c, m, INFINITE)
+#define COND_BROADCAST(c) WakeAllConditionVariable(c)
+#define COND_SIGNAL(c) WakeConditionVariable(c)
+#else
+typedef pthread_t thread_t;
+typedef pthread_mutex_t mutex_t;
+typedef pthread_cond_t cond_t;
+#define THREAD_CREATE(t, func, arg) pthread_create(t, NULL, func, arg)
+#define THREAD_JOIN(t) pthread_join(t, NULL)
+#define MUTEX_INIT(m) pthread_mutex_init(m, NULL)
+#define MUTEX_DESTROY(m) pthread_mutex_destroy(m)
+#define MUTEX_LOCK(m) pthread_mutex_lock(m)
+#define MUTEX_UNLOCK(m) pthread_mutex_unlock(m)
+#define COND_INIT(c) pthread_cond_init(c, NULL)
+#define COND_DESTROY(c) pthread_cond_destroy(c)
+#define COND_WAIT(c, m) pthread_cond_wait(c, m)
+#define COND_BROADCAST(c) pthread_cond_broadcast(c)
+#define COND_SIGNAL(c) pthread_cond_signal(c)
+#endif
+
+// ============== 线程池全局状态 ==============
+static thread_t g_threads[POOL_MAX_THREADS];
+static int g_thread_count = 0;
+
+static mutex_t g_lock;     // 保护下列批次状态
+static cond_t g_work_cond; // 新批次到达 / 关闭
+static cond_t g_done_cond; // 当前批次全部完成
+static mutex_t g_job_lock; // 串行化并发调用者
+
+static PoolTaskFunc g_func = NULL;
+static char *g_args = NULL;
+static size_t g_arg_size = 0;
+static int g_task_count = 0;
+static atomic_int g_next_task = 0;   // 原子任务游标
+static int g_active_workers = 0;     // 尚未完成当前批次的线程数
+static unsigned long g_generation = 0; // 批次编号
+static int g_shutdown = 0;
+
+// 标记当前线程是否为池内工作线程 (用于检测嵌套调用)
+static _Thread_local int tls_in_pool = 0;
+
+// 获取 CPU 逻辑核心数
+static int detect_cpu_count(void) {
+#ifdef _WIN32
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return (int)info.dwNumberOfProcessors;
+#else
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? (int)n : 1;
+#endif
+}
+
+// ============== 工作线程主循环 ==============
+#ifdef _WIN32
+static DWORD WINAPI pool_worker(void *arg) {
+#else
+static void *pool_worker(void *arg) {
+#endif
+  (void)arg;
+  unsigned long seen_generation = 0;
+  tls_in_pool = 1;
+
+  MUTEX_LOCK(&g_lock);
+  for (;;) {
+    while (!g_shutdown && g_generation == seen_generation) {
+      COND_WAIT(&g_work_cond, &g_lock);
+    }
+    if (g_shutdown)
+      break;
+
+    seen_generation = g_generation;
+    PoolTaskFunc func = g_func;
+    char *args = g_args;
+    size_t arg_size = g_arg_size;
+    int task_count = g_task_count;
+    MUTEX_UNLOCK(&g_lock);
+
+    // 领取任务直到本批次耗尽
+    for (;;) {
+      int idx = atomic_fetch_add(&g_next_task, 1);
+      if (idx >= task_count)
+        break;
+      func(args + (size_t)idx * arg_size);
+    }
+
+    MUTEX_LOCK(&g_lock);
+    if (--g_active_workers == 0) {
+      COND_SIGNAL(&g_done_cond);
+    }
+  }
+  MUTEX_UNLOCK(&g_lock);
+
+#ifdef _WIN32
+  return 0;
+#else
+  return NULL;
+#endif
+}
+
+// ============== 公共接口实现 ==============
+
+int thread_pool_init(int thread_count) {
+  if (g_thread_count > 0)
+    return 0;
+
+  if (thread_count <= 0)
+    thread_count = detect_cpu_count();
+  if (thread_count > POOL_MAX_THREADS)
+    thread_count = POOL_MAX_THREADS;
+
+  MUTEX_INIT(&g_lock);
+  MUTEX_INIT(&g_job_lock);
+  COND_INIT(&g_work_cond);
+  COND_INIT(&g_done_cond);
+  g_shutdown = 0;
+  g_generation = 0;
+
+  for (int i = 0; i < thread_count; i++) {
+    if (THREAD_CREATE(&g_threads[i], pool_worker, NULL) != 0) {
+      fprintf(stderr, "[Error] 无法创建线程池线程 %d\n", i);
+      // 回收已创建的线程
+      MUTEX_LOCK(&g_lock);
+      g_shutdown = 1;
+      COND_BROADCAST(&g_work_cond);
+      MUTEX_UNLOCK(&g_lock);
+      for (int j = 0; j < i; j++) {
+        THREAD_JOIN(g_threads[j]);
+      }
+      COND_DESTROY(&g_work_cond);
+      COND_DESTROY(&g_done_cond);
+      MUTEX_DESTROY(&g_job_lock);
+      MUTEX_DESTROY(&g_lock);
+      return -1;
+    }
+  }
+
+  g_thread_count = thread_count;
+  printf("[Pool] 线程池已启动 (%d 线程)\n", thread_count);
+  return 0;
+}
+
+void thread_pool_cleanup(void) {
+  if (g_thread_count == 0)
+    return;
+
+  MUTEX_LOCK(&g_lock);
+  g_shutdown = 1;
+  COND_BROADCAST(&g_work_cond);
+  MUTEX_UNLOCK(&g_lock);
+
+  for (int i = 0; i < g_thread_count; i++) {
+    THREAD_JOIN(g_threads[i]);
+  }
+
+  COND_DESTROY(&g_work_cond);
+  COND_DESTROY(&g_done_cond);
+  MUTEX_DESTROY(&g_job_lock);
+  MUTEX_DESTROY(&g_lock);
+  g_thread_count = 0;
+}
+
+int thread_pool_size(void) { return g_thread_count; }
+
+int thread_pool_run(PoolTaskFunc func, void *args, size_t arg_size,
+                    int task_count) {
+  if (!func || task_count <= 0)
+    return 0;
+
+  // 嵌套调用：直接在当前工作线程串行执行
+  if (tls_in_pool) {
+    for (int i = 0; i < task_count; i++) {
+      func((char *)args + (size_t)i * arg_size);
+    }
+    return 0;
+  }
+
+  // 不在此处惰性创建：预热线程与主线程可能同时提交，创建过程并非线程安全
+  if (g_thread_count == 0) {
+    fprintf(stderr, "[Error] 线程池未初始化，须先调用 thread_pool_init\n");
+    return -1;
+  }
+
+  MUTEX_LOCK(&g_job_lock);
+  MUTEX_LOCK(&g_lock);
+
+  g_func = func;
+  g_args = (char *)args;
+  g_arg_size = arg_size;
+  g_task_count = task_count;
+  atomic_store(&g_next_task, 0);
+  g_active_workers = g_thread_count;
+  g_generation++;
+  COND_BROADCAST(&g_work_cond);
+
+  while (g_active_workers > 0) {
+    COND_WAIT(&g_done_cond, &g_lock);
+  }
+
+  g_func = NULL;
+  g_args = NULL;
+  MUTEX_UNLOCK(&g_lock);
+  MUTEX_UNLOCK(&g_job_lock);
+  return 0;
+}
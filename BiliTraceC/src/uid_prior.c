@@ -0,0 +1,151 @@
+/**
+ * uid_prior.c
+ * UID 先验密度加载与候选排序实现
+ *
+ * 先验文件格式 (小端序，v1)：
+ *   uint32 magic ("UIDP")、version、sample_count、legacy_bins、prefix_count
+ *   uint32 legacy_counts[legacy_bins]
+ *   { uint32 prefix5; uint32 count; } prefixes[prefix_count]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "uid_prior.h"
+
+#define PRIOR_MAGIC 0x50444955u // "UIDP" (小端)
+#define PRIOR_VERSION 1
+#define PRIOR_LEGACY_BINS 23          // uid / 10^8 ∈ [0, 22]
+#define PRIOR_LEGACY_SPAN 100000000ULL // 旧版区间宽度 (10^8)
+#define PRIOR_LEGACY_MAX 2200000000ULL // 旧版 UID 上限
+#define PRIOR_PREFIX_MIN 10000         // 5 位前缀范围 [10000, 99999]
+#define PRIOR_PREFIX_COUNT 90000
+#define PRIOR_PREFIX_SPAN 100000000000ULL // 16 位 UID 前缀区间宽度 (10^11)
+#define PRIOR_ALPHA 0.5 // 加性平滑：未采样到的区间仍保留少量权重
+
+static uint32_t g_legacy[PRIOR_LEGACY_BINS];
+static uint32_t *g_prefix = NULL; // 按 prefix5 - PRIOR_PREFIX_MIN 直接寻址
+
+// 按小端序读取 uint32 (与本机字节序无关)
+static int read_u32(FILE *f, uint32_t *value) {
+  uint8_t b[4];
+  if (fread(b, 1, sizeof(b), f) != sizeof(b))
+    return -1;
+  *value = (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) |
+           ((uint32_t)b[3] << 24);
+  return 0;
+}
+
+int uid_prior_load(const char *path) {
+  if (!path)
+    path = UID_PRIOR_DEFAULT_PATH;
+
+  FILE *f = fopen(path, "rb");
+  if (!f)
+    return -1;
+
+  uint32_t magic, version, samples, legacy_bins, prefix_count;
+  if (read_u32(f, &magic) != 0 || read_u32(f, &version) != 0 ||
+      read_u32(f, &samples) != 0 || read_u32(f, &legacy_bins) != 0 ||
+      read_u32(f, &prefix_count) != 0 || magic != PRIOR_MAGIC ||
+      legacy_bins != PRIOR_LEGACY_BINS) {
+    fclose(f);
+    printf("[Prior] %s 格式不符，忽略\n", path);
+    return -1;
+  }
+  if (version != PRIOR_VERSION) {
+    fclose(f);
+    printf("[Prior] %s 版本 v%u 不受支持，忽略\n", path, version);
+    return -1;
+  }
+
+  uint32_t legacy[PRIOR_LEGACY_BINS];
+  uint32_t *prefix = (uint32_t *)calloc(PRIOR_PREFIX_COUNT, sizeof(uint32_t));
+  int rc = prefix ? 0 : -1;
+  for (uint32_t i = 0; rc == 0 && i < PRIOR_LEGACY_BINS; i++) {
+    rc = read_u32(f, &legacy[i]);
+  }
+  for (uint32_t i = 0; rc == 0 && i < prefix_count; i++) {
+    uint32_t p, count;
+    if (read_u32(f, &p) != 0 || read_u32(f, &count) != 0 ||
+        p < PRIOR_PREFIX_MIN || p >= PRIOR_PREFIX_MIN + PRIOR_PREFIX_COUNT) {
+      rc = -1;
+      break;
+    }
+    prefix[p - PRIOR_PREFIX_MIN] = count;
+  }
+  fclose(f);
+
+  if (rc != 0) {
+    free(prefix);
+    printf("[Prior] %s 内容不完整，忽略\n", path);
+    return -1;
+  }
+
+  uid_prior_free();
+  memcpy(g_legacy, legacy, sizeof(g_legacy));
+  g_prefix = prefix;
+  printf("[Prior] 已加载 UID 先验: %u 个样本，%u 个 16 位前缀\n", samples,
+         prefix_count);
+  return 0;
+}
+
+int uid_prior_loaded(void) { return g_prefix != NULL; }
+
+double uid_prior_score(uint64_t uid) {
+  if (!g_prefix)
+    return 0.0;
+
+  if (uid > 0 && uid <= PRIOR_LEGACY_MAX) {
+    return (g_legacy[uid / PRIOR_LEGACY_SPAN] + PRIOR_ALPHA) /
+           (double)PRIOR_LEGACY_SPAN;
+  }
+  if (uid >= 1000000000000000ULL && uid < 10000000000000000ULL) {
+    uint32_t p = (uint32_t)(uid / PRIOR_PREFIX_SPAN);
+    return (g_prefix[p - PRIOR_PREFIX_MIN] + PRIOR_ALPHA) /
+           (double)PRIOR_PREFIX_SPAN;
+  }
+  return 0.0;
+}
+
+typedef struct {
+  uint64_t uid;
+  double score;
+  int index; // 原始位置 (同分时保持原顺序)
+} RankedUid;
+
+static int ranked_compare(const void *a, const void *b) {
+  const RankedUid *ra = (const RankedUid *)a;
+  const RankedUid *rb = (const RankedUid *)b;
+  if (ra->score != rb->score)
+    return ra->score < rb->score ? 1 : -1;
+  return (ra->index > rb->index) - (ra->index < rb->index);
+}
+
+int uid_prior_rank(uint64_t *uids, int count) {
+  if (!g_prefix || count < 2)
+    return 0;
+
+  RankedUid *ranked = (RankedUid *)malloc(sizeof(RankedUid) * (size_t)count);
+  if (!ranked)
+    return -1;
+  for (int i = 0; i < count; i++) {
+    ranked[i].uid = uids[i];
+    ranked[i].score = uid_prior_score(uids[i]);
+    ranked[i].index = i;
+  }
+  qsort(ranked, (size_t)count, sizeof(RankedUid), ranked_compare);
+  for (int i = 0; i < count; i++) {
+    uids[i] = ranked[i].uid;
+  }
+  free(ranked);
+  return 0;
+}
+
+void uid_prior_free(void) {
+  free(g_prefix);
+  g_prefix = NULL;
+  memset(g_legacy, 0, sizeof(g_legacy));
+}